@@ -0,0 +1,36 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "coverage_binner.hpp"
+
+/*
+ * Kernel: CoverageBinner::add sobre reads ordenados de 150 bp a ~30x
+ * en un cromosoma de 5 Mbp con bins de 1000 bp. Items = reads.
+ */
+
+int main(int argc, char* argv[]) {
+
+    const int64_t contig_len = 5000000;
+    const int read_len = 150;
+    const int bin_size = 1000;
+    const size_t n_reads = contig_len * 30 / read_len;
+
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<int64_t> pick(0, contig_len - read_len);
+
+    std::vector<int64_t> starts(n_reads);
+    for (auto& s : starts)
+        s = pick(rng);
+    std::sort(starts.begin(), starts.end());
+
+    cnv::CoverageBinner binner(bin_size);
+
+    return bench::run("binning", n_reads, [&]() {
+        binner.clear();
+        for (int64_t s : starts)
+            binner.add(s, s + read_len);
+        bench::do_not_optimize(binner.counts()[binner.counts().size() / 2]);
+    }, argc, argv);
+}
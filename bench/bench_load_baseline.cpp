@@ -0,0 +1,40 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "bench_util.hpp"
+#include "csv_io.hpp"
+
+/*
+ * Kernel: parseo CSV de load_baseline. El archivo tiene 10k filas y el
+ * bin_size buscado está en la última, así que se recorren todas.
+ * Items = filas leídas.
+ */
+
+int main(int argc, char* argv[]) {
+
+    const int n_rows = 10000;
+    const std::string path = "bench_load_baseline.csv";
+
+    std::remove(path.c_str());
+    for (int i = 1; i <= n_rows; ++i) {
+        cnv::BaselineRow r{};
+        r.bin_size = i;
+        r.total_bins = 3000000;
+        r.p1 = 120; r.p5 = 150; r.p25 = 180; r.p50 = 200; r.p75 = 220;
+        r.p95 = 250; r.p99 = 300; r.min = 1; r.max = 5000; r.iqr = 40;
+        r.deletion_threshold = 100; r.duplication_threshold = 300;
+        r.kll_items = 1200; r.kll_k = 400; r.kll_time_sec = 0.5;
+        r.sample_fraction = 1.0;
+        cnv::append_baseline_row(path, r);
+    }
+
+    int rc = bench::run("load_baseline", n_rows, [&]() {
+        cnv::BaselineStats b = cnv::load_baseline(path, n_rows);
+        bench::do_not_optimize(uint64_t(b.p50));
+    }, argc, argv);
+
+    std::remove(path.c_str());
+
+    return rc;
+}
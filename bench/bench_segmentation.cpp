@@ -0,0 +1,43 @@
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "cnv_segmenter.hpp"
+
+/*
+ * Kernel: detect_cnvs_for_chr sobre 1M bins con cobertura ~200 y
+ * eventos de 50 bins cada 10 kbins. Items = bins segmentados.
+ */
+
+int main(int argc, char* argv[]) {
+
+    const size_t n_bins = 1000000;
+
+    std::mt19937_64 rng(1);
+    std::poisson_distribution<uint32_t> normal(200.0);
+    std::poisson_distribution<uint32_t> del(100.0);
+    std::poisson_distribution<uint32_t> dup(300.0);
+
+    std::vector<uint32_t> counts(n_bins);
+    for (size_t i = 0; i < n_bins; ++i) {
+        size_t phase = i % 10000;
+        if (phase < 50)
+            counts[i] = (i / 10000) % 2 ? dup(rng) : del(rng);
+        else
+            counts[i] = normal(rng);
+    }
+
+    cnv::BaselineStats base{};
+    base.bin_size = 1000;
+    base.p50 = 200.0f;
+    base.deletion_threshold = 100.0f;
+    base.duplication_threshold = 300.0f;
+
+    cnv::CallArena calls;
+
+    return bench::run("segmentation", n_bins, [&]() {
+        calls.reset();
+        cnv::detect_cnvs_for_chr(0, counts, 0, base, calls);
+        bench::do_not_optimize(calls.size());
+    }, argc, argv);
+}
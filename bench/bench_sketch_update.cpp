@@ -0,0 +1,28 @@
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "quantile_backend.hpp"
+
+/*
+ * Kernel: update_sketch con K = 400 sobre 1M bins de cobertura ~200.
+ * Items = bins enviados al sketch.
+ */
+
+int main(int argc, char* argv[]) {
+
+    const size_t n_bins = 1000000;
+
+    std::mt19937_64 rng(1);
+    std::poisson_distribution<uint32_t> cov(200.0);
+
+    std::vector<uint32_t> counts(n_bins);
+    for (auto& c : counts)
+        c = cov(rng);
+
+    return bench::run("sketch_update", n_bins, [&]() {
+        cnv::CoverageSketch sketch(400);
+        cnv::update_sketch(sketch, counts);
+        bench::do_not_optimize(sketch.get_n());
+    }, argc, argv);
+}
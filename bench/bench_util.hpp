@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+/*
+ * ============================
+ *   Utilidades de microbenchmark
+ * ============================
+ *
+ * Cada benchmark mide un kernel aislado en items por segundo. Como el
+ * throughput absoluto depende de la máquina y de su carga, la regresión
+ * se evalúa sobre el cociente entre el kernel y un bucle de referencia
+ * fijo medido en el mismo proceso, intercalado con el kernel: una
+ * máquina más lenta u ocupada baja ambos. Se toma la mediana de varias
+ * rondas y se compara con bench/throughput_baseline.csv
+ * (kernel,min_ratio_vs_reference):
+ *
+ *   --baseline <csv>   termina con código 1 si el cociente queda bajo
+ *                      el mínimo del kernel en todos los intentos
+ *   --record <csv>     guarda el cociente medido * (1 - margen) como
+ *                      nuevo mínimo del kernel
+ *   --margin <f>       margen de --record (por defecto 0.2); debe
+ *                      superar la dispersión observada del kernel
+ */
+
+namespace bench {
+
+// Evita que el compilador descarte el resultado del kernel
+inline void do_not_optimize(uint64_t v) {
+    static volatile uint64_t sink;
+    sink = sink + v;
+}
+
+// Tiempo de CPU del hilo: no cuenta el tiempo en que otro proceso
+// ocupa el núcleo, que en una máquina compartida domina el ruido
+inline double thread_cpu_seconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Repite fn() al menos min_seconds de CPU y devuelve el mejor items/s
+template <typename F>
+double measure(uint64_t items_per_call, F&& fn, double min_seconds = 0.5) {
+    fn(); // calentamiento
+
+    double best = 0.0;
+    double total = 0.0;
+    int reps = 0;
+
+    while (total < min_seconds || reps < 3) {
+        double t1 = thread_cpu_seconds();
+        fn();
+        double t2 = thread_cpu_seconds();
+
+        double secs = t2 - t1;
+        total += secs;
+        reps++;
+
+        if (secs > 0.0)
+            best = std::max(best, items_per_call / secs);
+    }
+
+    return best;
+}
+
+/*
+ * Bucle de referencia: recorrido con dependencia aritmética sobre un
+ * buffer que entra en la cache L2. No cambia con el código del repo, así
+ * que solo refleja la velocidad y la carga de la máquina.
+ */
+inline double reference_rate(double min_seconds) {
+    static std::vector<uint32_t> buf(1 << 16, 1);
+
+    return measure(buf.size(), [&]() {
+        uint64_t x = 1;
+        for (auto& v : buf) {
+            x = x * 6364136223846793005ULL + v;
+            v = uint32_t(x >> 33);
+        }
+        do_not_optimize(x);
+    }, min_seconds);
+}
+
+struct Measurement {
+    double items_per_sec;   // mediana de las rondas
+    double ratio;           // mediana de kernel / referencia
+};
+
+// Rondas de referencia + kernel; devuelve las medianas
+template <typename F>
+Measurement measure_relative(uint64_t items_per_call, F&& fn, int rounds = 7) {
+    std::vector<double> ips, ratios;
+
+    for (int r = 0; r < rounds; ++r) {
+        double ref = reference_rate(0.05);
+        double k = measure(items_per_call, fn, 0.1);
+        ips.push_back(k);
+        ratios.push_back(k / ref);
+    }
+
+    auto median = [](std::vector<double>& v) {
+        std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+        return v[v.size() / 2];
+    };
+    return {median(ips), median(ratios)};
+}
+
+inline std::vector<std::pair<std::string, double>> read_baseline(const std::string& path) {
+    std::vector<std::pair<std::string, double>> rows;
+    std::ifstream in(path);
+
+    std::string line;
+    std::getline(in, line); // header
+
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string kernel, value;
+        std::getline(ss, kernel, ',');
+        std::getline(ss, value, ',');
+        if (!kernel.empty() && !value.empty())
+            rows.emplace_back(kernel, std::stod(value));
+    }
+    return rows;
+}
+
+/*
+ * Mide el kernel y lo compara con el mínimo. Cada intento es la mediana
+ * de varias rondas; si queda bajo el mínimo se repite hasta ATTEMPTS
+ * veces y solo se reporta regresión si todos los intentos quedan bajo.
+ * --record usa la mediana de ATTEMPTS intentos.
+ */
+template <typename F>
+int run(const std::string& kernel, uint64_t items_per_call, F&& fn, int argc, char* argv[]) {
+    constexpr int ATTEMPTS = 3;
+
+    std::string baseline_file, record_file;
+    double margin = 0.2;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--baseline"))    baseline_file = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--record")) record_file = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--margin")) margin = std::stod(argv[i + 1]);
+    }
+
+    auto print = [&](const Measurement& m) {
+        std::cout << kernel << "," << std::fixed << m.items_per_sec << " items/s,"
+                  << m.ratio << " x referencia\n";
+    };
+
+    if (!record_file.empty()) {
+        std::vector<Measurement> ms;
+        for (int a = 0; a < ATTEMPTS; ++a) {
+            ms.push_back(measure_relative(items_per_call, fn));
+            print(ms.back());
+        }
+        std::sort(ms.begin(), ms.end(),
+                  [](const Measurement& a, const Measurement& b) { return a.ratio < b.ratio; });
+        double floor = ms[ATTEMPTS / 2].ratio * (1.0 - margin);
+
+        auto rows = read_baseline(record_file);
+        bool found = false;
+        for (auto& r : rows)
+            if (r.first == kernel) {
+                r.second = floor;
+                found = true;
+            }
+        if (!found)
+            rows.emplace_back(kernel, floor);
+
+        std::ofstream out(record_file);
+        out << "kernel,min_ratio_vs_reference\n";
+        for (const auto& r : rows)
+            out << r.first << "," << std::fixed << r.second << "\n";
+        return 0;
+    }
+
+    double min_ratio = -1.0;
+    if (!baseline_file.empty()) {
+        for (const auto& r : read_baseline(baseline_file))
+            if (r.first == kernel)
+                min_ratio = r.second;
+        if (min_ratio < 0.0)
+            std::cerr << "Aviso: " << kernel << " no tiene mínimo en " << baseline_file << "\n";
+    }
+
+    Measurement m{};
+    for (int a = 0; a < ATTEMPTS; ++a) {
+        m = measure_relative(items_per_call, fn);
+        print(m);
+        if (m.ratio >= min_ratio)
+            return 0;
+    }
+
+    std::cerr << "REGRESIÓN en " << kernel << ": " << m.ratio
+              << " x referencia < mínimo " << min_ratio
+              << " en " << ATTEMPTS << " intentos\n";
+    return 1;
+}
+
+} // namespace bench
@@ -1,20 +1,158 @@
 #include <iostream>
 #include <iomanip>
-#include <unordered_map>
 #include <string>
 #include <chrono>
-#include <fstream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "quantile_backend.hpp"
+#include "csv_io.hpp"
+#include "result_cache.hpp"
+
+using namespace cnv;
+
+/*
+ * ============================
+ *   Modo muestreado (--sample-fraction)
+ * ============================
+ *
+ * En vez de recorrer el BAM completo se eligen al azar ventanas genómicas
+ * de todos los cromosomas y solo se leen, vía índice .bai, los reads que
+ * las solapan. Las ventanas miden un múltiplo de bin_size cercano a la
+ * granularidad del índice lineal (16 kbp), de modo que cada consulta
+ * salta directamente al primer bloque BGZF relevante.
+ *
+ * Un bin se cuenta igual que en la pasada completa: todo read que aporta
+ * a un bin lo solapa, así que la consulta por región lo devuelve.
+ */
+
+constexpr int64_t LINEAR_INDEX_WINDOW = 1 << 14;
+constexpr double Z_95 = 1.959964;
+
+struct SampleWindow {
+    int tid;
+    int64_t beg;
+    int64_t end;
+};
+
+struct SampleReport {
+    uint64_t windows_total = 0;
+    uint64_t windows_sampled = 0;
+    uint64_t reads_read = 0;
+    uint64_t reads_mapped_total = 0;
+};
+
+std::vector<SampleWindow> pick_sample_windows(
+    const sam_hdr_t* header,
+    const hts_idx_t* idx,
+    int64_t window_len,
+    double fraction,
+    uint64_t seed,
+    SampleReport& report
+) {
+    // Ventanas por cromosoma; se omiten los que el índice reporta sin reads
+    std::vector<int> tids;
+    std::vector<uint64_t> first_window;
+    uint64_t total = 0;
+
+    for (int tid = 0; tid < header->n_targets; ++tid) {
+        uint64_t mapped = 0, unmapped = 0;
+        if (hts_idx_get_stat(idx, tid, &mapped, &unmapped) < 0 || mapped == 0)
+            continue;
+
+        report.reads_mapped_total += mapped;
+        tids.push_back(tid);
+        first_window.push_back(total);
+        total += (header->target_len[tid] + window_len - 1) / window_len;
+    }
+
+    report.windows_total = total;
+    if (total == 0)
+        return {};
+
+    uint64_t m = static_cast<uint64_t>(std::llround(fraction * total));
+    m = std::min(std::max<uint64_t>(m, 1), total);
+
+    // Fisher-Yates parcial: m ventanas distintas, luego en orden genómico
+    std::vector<uint64_t> ids(total);
+    for (uint64_t i = 0; i < total; ++i)
+        ids[i] = i;
+
+    std::mt19937_64 rng(seed);
+    for (uint64_t i = 0; i < m; ++i) {
+        std::uniform_int_distribution<uint64_t> pick(i, total - 1);
+        std::swap(ids[i], ids[pick(rng)]);
+    }
+    ids.resize(m);
+    std::sort(ids.begin(), ids.end());
+
+    std::vector<SampleWindow> windows;
+    windows.reserve(m);
+    for (uint64_t id : ids) {
+        size_t c = std::upper_bound(first_window.begin(), first_window.end(), id)
+                   - first_window.begin() - 1;
+        int64_t beg = int64_t(id - first_window[c]) * window_len;
+        windows.push_back({tids[c], beg, beg + window_len});
+    }
+
+    report.windows_sampled = m;
+    return windows;
+}
+
+/*
+ * ============================
+ *   Entrada desde cache de cobertura (--coverage)
+ * ============================
+ *
+ * Lee la cobertura por bin de un .cov (por ejemplo, el que escribe
+ * generador_sintetico --output cache) en vez del BAM. Los conteos son
+ * los mismos que daría la pasada sobre el BAM, así que la fila de
+ * baseline también lo es.
+ */
+
+BaselineRow baseline_from_coverage(const std::string& cov_file, int bin_size, int k) {
+    int cov_bin_size = 0;
+    std::vector<CoverageContig> contigs = read_coverage_cache(cov_file, cov_bin_size);
+    if (cov_bin_size != bin_size)
+        throw std::runtime_error(cov_file + " tiene bin size " + std::to_string(cov_bin_size) +
+                                 ", no " + std::to_string(bin_size));
+
+    using clock = std::chrono::steady_clock;
+    CoverageSketch coverage_sketch(k);
+    uint64_t total_bins = 0;
 
-#include <htslib/sam.h>
-#include "kll_sketch.hpp"
+    auto t1 = clock::now();
+    for (const CoverageContig& c : contigs) {
+        total_bins += (c.length + bin_size - 1) / bin_size;
+        update_sketch(coverage_sketch, c.counts);
+    }
+    std::chrono::duration<double> kll_time = clock::now() - t1;
 
-using namespace datasketches;
+    return make_baseline_row(coverage_sketch, bin_size, total_bins, kll_time.count());
+}
 
 int main(int argc, char* argv[]) {
 
-    if (argc != 4) {
-        std::cerr << "Uso: " << argv[0]
-                  << " <archivo.bam> <bin_size> <output.csv>\n";
+    // --coverage <archivo.cov> reemplaza al BAM como primer argumento
+    const char* prog = argv[0];
+    bool from_coverage = argc > 1 && std::string(argv[1]) == "--coverage";
+    if (from_coverage) {
+        argv++;
+        argc--;
+    }
+
+    if (argc < 4) {
+        std::cerr << "Uso: " << prog
+                  << " <archivo.bam> <bin_size> <output.csv>"
+                  << " [--k <K>] [--sample-fraction <f>] [--seed <n>] [--cache <dir>]\n"
+                  << "     " << prog
+                  << " --coverage <archivo.cov> <bin_size> <output.csv> [--k <K>]\n";
         return 1;
     }
 
@@ -22,140 +160,219 @@ int main(int argc, char* argv[]) {
     int bin_size = std::atoi(argv[2]);
     const char* csv_file = argv[3];
 
-    // --- Abrir BAM ---
-    samFile* bam_fp = sam_open(bam_file, "r");
-    if (!bam_fp) {
-        std::cerr << "Error al abrir BAM\n";
+    double sample_fraction = 0.0;
+    uint64_t seed = 1;
+    int k = DEFAULT_K;
+    std::string cache_dir;
+
+    for (int i = 4; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--sample-fraction" && i + 1 < argc) {
+            // Un valor mal escrito no debe caer en la pasada completa
+            const char* arg = argv[++i];
+            char* endp = nullptr;
+            sample_fraction = std::strtod(arg, &endp);
+            if (endp == arg || *endp != '\0' || !(sample_fraction > 0.0 && sample_fraction <= 1.0)) {
+                std::cerr << "--sample-fraction debe estar en (0, 1]: " << arg << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "--k" && i + 1 < argc) {
+            const char* arg = argv[++i];
+            char* endp = nullptr;
+            long v = std::strtol(arg, &endp, 10);
+            if (endp == arg || *endp != '\0' || v < 8 || v > 65535) {
+                std::cerr << "--k debe ser un entero en [8, 65535]: " << arg << "\n";
+                return 1;
+            }
+            k = int(v);
+        }
+        else if (opt == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (opt == "--cache" && i + 1 < argc)
+            cache_dir = argv[++i];
+        else {
+            std::cerr << "Opción desconocida: " << opt << "\n";
+            return 1;
+        }
+    }
+
+    if (sample_fraction > 0.0 && !cache_dir.empty()) {
+        std::cerr << "--sample-fraction y --cache no se pueden combinar\n";
         return 1;
     }
 
-    sam_hdr_t* header = sam_hdr_read(bam_fp);
-    if (!header) {
-        std::cerr << "Error leyendo header\n";
-        sam_close(bam_fp);
+    if (from_coverage && (sample_fraction > 0.0 || !cache_dir.empty())) {
+        std::cerr << "--coverage no se puede combinar con --sample-fraction ni --cache\n";
         return 1;
     }
 
-    bam1_t* aln = bam_init1();
+    try {
+        if (from_coverage) {
+            append_baseline_row(csv_file, baseline_from_coverage(bam_file, bin_size, k));
+            return 0;
+        }
 
-    // --- KLL ---
-    constexpr int K = 400;
-    kll_sketch<float> coverage_sketch(K);
+        BamScanner bam(bam_file);
 
-    using clock = std::chrono::steady_clock;
-    std::chrono::duration<double> kll_time{0};
+        // --- KLL ---
+        CoverageSketch coverage_sketch(k);
 
-    std::string current_chr;
-    std::unordered_map<uint32_t, uint32_t> bins;
-    bins.reserve(100000);
+        using clock = std::chrono::steady_clock;
+        std::chrono::duration<double> kll_time{0};
 
-    uint64_t total_reads = 0;
-    uint64_t total_bins = 0;
+        CoverageBinner binner(bin_size);
 
-    for (int i = 0; i < header->n_targets; ++i) {
-    uint64_t chr_len = header->target_len[i];
-    total_bins += (chr_len + bin_size - 1) / bin_size;
-}
+        uint64_t total_bins = bam.total_bins(bin_size);
 
+        SampleReport sample_report;
+        auto run_t1 = clock::now();
 
+        if (sample_fraction > 0.0) {
 
-    // --- Lectura BAM ---
-    while (sam_read1(bam_fp, header, aln) >= 0) {
+            // --- Lectura muestreada vía índice ---
+            hts_idx_t* idx = bam.index();
+            if (!idx) {
+                std::cerr << "Error: --sample-fraction requiere el índice .bai\n";
+                return 1;
+            }
 
-        total_reads++;
+            int64_t bins_per_window = std::max<int64_t>(1, LINEAR_INDEX_WINDOW / bin_size);
+            int64_t window_len = bins_per_window * bin_size;
 
-        if (aln->core.flag & (BAM_FUNMAP |
-                              BAM_FSECONDARY |
-                              BAM_FSUPPLEMENTARY |
-                              BAM_FDUP))
-            continue;
+            std::vector<SampleWindow> windows = pick_sample_windows(
+                bam.header(), idx, window_len, sample_fraction, seed, sample_report);
 
-        std::string chr = header->target_name[aln->core.tid];
+            // Ventanas contiguas del mismo cromosoma se leen en una sola
+            // consulta: un read que cruza el borde se lee (y cuenta) una vez
+            for (size_t i = 0; i < windows.size(); ) {
+                const SampleWindow& w = windows[i];
+                int64_t end = w.end;
+                size_t j = i + 1;
+                while (j < windows.size() && windows[j].tid == w.tid && windows[j].beg == end)
+                    end = windows[j++].end;
 
-        if (current_chr.empty())
-            current_chr = chr;
+                binner.reset_window(w.beg / bin_size, int64_t(j - i) * bins_per_window);
 
-        if (chr != current_chr) {
-            auto t1 = clock::now();
-            for (const auto& e : bins)
-                coverage_sketch.update(static_cast<float>(e.second));
-            auto t2 = clock::now();
-            kll_time += (t2 - t1);
+                sample_report.reads_read += bam.scan_region(
+                    w.tid, w.beg, end, DEFAULT_EXCLUDE_FLAGS,
+                    [&](int, int64_t start, int64_t read_end) { binner.add(start, read_end); });
 
-            bins.clear();
-            current_chr = chr;
-        }
+                auto t1 = clock::now();
+                update_sketch(coverage_sketch, binner.counts());
+                auto t2 = clock::now();
+                kll_time += (t2 - t1);
 
-        int start = aln->core.pos;
-        int end   = bam_endpos(aln);
+                i = j;
+            }
+        }
+        else if (!cache_dir.empty()) {
+
+            // --- Lectura incremental: solo cromosomas cuyo digest cambió ---
+            ResultCache cache(cache_dir);
+            std::vector<uint64_t> digests = cache.input_digests(bam_file, bam.header());
+
+            int contigs = 0, sketch_hits = 0, coverage_hits = 0;
+            std::vector<uint32_t> counts;
+
+            for (int tid = 0; tid < bam.num_contigs(); ++tid) {
+                if (bam.mapped_reads(tid) == 0)
+                    continue;
+
+                contigs++;
+                std::string name = bam.contig_name(tid);
+                uint64_t cov_key = coverage_key(digests[tid], bin_size, DEFAULT_EXCLUDE_FLAGS);
+                uint64_t kll_key = sketch_key(cov_key, k);
+
+                CoverageSketch contig_sketch(k);
+
+                if (cache.load_sketch(name, kll_key, contig_sketch)) {
+                    sketch_hits++;
+                }
+                else {
+                    if (load_or_scan_coverage(cache, bam, tid, cov_key,
+                                              DEFAULT_EXCLUDE_FLAGS, binner, counts))
+                        coverage_hits++;
+
+                    auto t1 = clock::now();
+                    update_sketch(contig_sketch, counts);
+                    auto t2 = clock::now();
+                    kll_time += (t2 - t1);
+
+                    cache.save_sketch(name, kll_key, contig_sketch);
+                }
+
+                // Sketch global = unión de los sketches por cromosoma
+                auto t1 = clock::now();
+                coverage_sketch.merge(contig_sketch);
+                auto t2 = clock::now();
+                kll_time += (t2 - t1);
+            }
+
+            std::cout << "Cache " << cache_dir << ": " << contigs << " cromosomas, "
+                      << sketch_hits << " sketches reutilizados, "
+                      << coverage_hits << " coberturas reutilizadas, "
+                      << contigs - sketch_hits - coverage_hits << " leídos del BAM\n";
+        }
+        else {
+
+            // --- Lectura BAM ---
+            bam.scan(DEFAULT_EXCLUDE_FLAGS,
+                [&](int, int64_t start, int64_t end) { binner.add(start, end); },
+                [&](int) {
+                    auto t1 = clock::now();
+                    update_sketch(coverage_sketch, binner.counts());
+                    auto t2 = clock::now();
+                    kll_time += (t2 - t1);
+
+                    binner.clear();
+                });
+        }
 
-        for (int p = start; p < end; p += bin_size) {
-            uint32_t bin = p / bin_size;
-            bins[bin]++;
+        std::chrono::duration<double> run_time = clock::now() - run_t1;
+
+        BaselineRow row = make_baseline_row(coverage_sketch, bin_size, total_bins, kll_time.count());
+        if (sample_fraction > 0.0)
+            row.sample_fraction = sample_fraction;
+
+        // --- Reporte del modo muestreado ---
+        if (sample_fraction > 0.0) {
+            const SampleReport& r = sample_report;
+            uint64_t n = std::max<uint64_t>(r.windows_sampled, 1);
+            double kll_eps = coverage_sketch.get_normalized_rank_error(false);
+
+            std::cout << std::fixed << std::setprecision(4);
+            std::cout << "Modo muestreado (seed " << seed << ")\n";
+            std::cout << "Ventanas leídas: " << r.windows_sampled << " / "
+                      << r.windows_total << " ("
+                      << 100.0 * r.windows_sampled / std::max<uint64_t>(r.windows_total, 1)
+                      << " %)\n";
+            std::cout << "Reads leídos: " << r.reads_read << " / "
+                      << r.reads_mapped_total << " mapeados ("
+                      << 100.0 * r.reads_read / std::max<uint64_t>(r.reads_mapped_total, 1)
+                      << " %)\n";
+            std::cout << "Tiempo total: " << run_time.count() << " s\n";
+
+            // IC al 95% por rank: la ventana es la unidad de muestreo (los bins
+            // de una misma ventana están correlacionados, así que usar el número
+            // de ventanas es conservador), más el error de rank propio del KLL.
+            std::cout << "cuantil,estimado,ic95_inf,ic95_sup\n";
+            for (double q : {0.01, 0.05, 0.25, 0.50, 0.75, 0.95, 0.99}) {
+                double half = Z_95 * std::sqrt(q * (1.0 - q) / n) + kll_eps;
+                std::cout << "p" << int(std::lround(q * 100)) << ","
+                          << coverage_sketch.get_quantile(q) << ","
+                          << coverage_sketch.get_quantile(std::max(0.0, q - half)) << ","
+                          << coverage_sketch.get_quantile(std::min(1.0, q + half)) << "\n";
+            }
         }
-    }
 
-    // Flush final
-    auto t1 = clock::now();
-    for (const auto& e : bins)
-        coverage_sketch.update(static_cast<float>(e.second));
-    auto t2 = clock::now();
-    kll_time += (t2 - t1);
-
-    bam_destroy1(aln);
-    sam_hdr_destroy(header);
-    sam_close(bam_fp);
-
-    // --- Percentiles aproximados ---
-    float p1  = coverage_sketch.get_quantile(0.01);
-    float p5  = coverage_sketch.get_quantile(0.05);
-    float p25 = coverage_sketch.get_quantile(0.25);
-    float p50 = coverage_sketch.get_quantile(0.50);
-    float p75 = coverage_sketch.get_quantile(0.75);
-    float p95 = coverage_sketch.get_quantile(0.95);
-    float p99 = coverage_sketch.get_quantile(0.99);
-
-    float minv = coverage_sketch.get_min_item();
-    float maxv = coverage_sketch.get_max_item();
-
-    float iqr = p75 - p25;
-    float deletion_threshold    = p50 * 0.5f;
-    float duplication_threshold = p50 * 1.5f;
-
-    size_t kll_items = coverage_sketch.get_num_retained();
-
-    // --- CSV ---
-    bool write_header = false;
-    std::ifstream check(csv_file);
-    if (!check.good())
-        write_header = true;
-    check.close();
-
-    std::ofstream out(csv_file, std::ios::app);
-    out << std::fixed << std::setprecision(6);
-
-    if (write_header) {
-        out << "bin_size,"
-            << "total_bins," 
-            << "p1,p5,p25,p50,p75,p95,p99,"
-            << "min,max,iqr,"
-            << "deletion_threshold,duplication_threshold,"
-            << "kll_items,kll_k,kll_time_sec\n";
+        // --- CSV ---
+        append_baseline_row(csv_file, row);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
     }
-
-    out << bin_size << ","
-        << total_bins << ","
-        << p1 << "," << p5 << "," << p25 << "," << p50 << ","
-        << p75 << "," << p95 << "," << p99 << ","
-        << minv << "," << maxv << ","
-        << iqr << ","
-        << deletion_threshold << ","
-        << duplication_threshold << ","
-        << kll_items << ","
-        << K << ","
-        << kll_time.count() << "\n";
-
-    out.close();
 
     return 0;
 }
@@ -1,15 +1,15 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
-#include <unordered_map>
 #include <vector>
 #include <string>
 #include <chrono>
 
-#include <htslib/sam.h>
-#include "kll_sketch.hpp"
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "quantile_backend.hpp"
 
-using namespace datasketches;
+using namespace cnv;
 using hr_clock = std::chrono::high_resolution_clock;
 
 int main(int argc, char* argv[]) {
@@ -24,99 +24,71 @@ int main(int argc, char* argv[]) {
     std::vector<int> bin_sizes = {100 , 200, 500, 1000, 2000, 5000, 10000};
     const int K = 400;
 
+    // Este experimento conserva los duplicados
+    constexpr uint16_t EXCLUDE_FLAGS =
+        BAM_FUNMAP | BAM_FSECONDARY | BAM_FSUPPLEMENTARY;
+
     std::ofstream csv("bin_experiment.csv");
     csv << "bin_size,num_bins,p25,p50,p75,p95,"
            "kll_items,kll_k,kll_time_sec,kll_memory_bytes\n";
 
-    for (int bin_size : bin_sizes) {
-
-        std::cout << "\n=== BIN SIZE: " << bin_size << " bp ===\n";
+    try {
+        for (int bin_size : bin_sizes) {
 
-        // --- Abrir BAM ---
-        samFile* bam_fp = sam_open(bam_file, "r");
-        if (!bam_fp) {
-            std::cerr << "Error abriendo BAM\n";
-            return 1;
-        }
+            std::cout << "\n=== BIN SIZE: " << bin_size << " bp ===\n";
 
-        sam_hdr_t* header = sam_hdr_read(bam_fp);
-        bam1_t* aln = bam_init1();
+            // --- Abrir BAM ---
+            BamScanner bam(bam_file);
 
-        kll_sketch<float> coverage_sketch(K);
-        std::unordered_map<uint32_t, uint32_t> bins;
-        bins.reserve(200000);
+            CoverageSketch coverage_sketch(K);
+            CoverageBinner binner(bin_size);
 
-        std::string current_chr;
-        uint64_t total_bins = 0;
+            uint64_t total_bins = bam.total_bins(bin_size);
 
-        for (int i = 0; i < header->n_targets; ++i) {
-        uint64_t chr_len = header->target_len[i];
-        total_bins += (chr_len + bin_size - 1) / bin_size;
-    }
+            std::chrono::duration<double> kll_elapsed{0};
 
-        while (sam_read1(bam_fp, header, aln) >= 0) {
+            bam.scan(EXCLUDE_FLAGS,
+                [&](int, int64_t start, int64_t end) { binner.add(start, end); },
+                [&](int) {
+                    // --- Timing KLL ---
+                    auto t1 = hr_clock::now();
+                    update_sketch(coverage_sketch, binner.counts());
+                    auto t2 = hr_clock::now();
+                    kll_elapsed += (t2 - t1);
 
-            if (aln->core.flag & (BAM_FUNMAP |
-                                  BAM_FSECONDARY |
-                                  BAM_FSUPPLEMENTARY))
-                continue;
+                    binner.clear();
+                });
 
-            std::string chr = header->target_name[aln->core.tid];
+            double kll_time = kll_elapsed.count();
 
-            if (current_chr.empty())
-                current_chr = chr;
+            float p25 = coverage_sketch.get_quantile(0.25);
+            float p50 = coverage_sketch.get_quantile(0.50);
+            float p75 = coverage_sketch.get_quantile(0.75);
+            float p95 = coverage_sketch.get_quantile(0.95);
 
-            if (chr != current_chr) {
-                for (const auto& e : bins)
-                    coverage_sketch.update((float)e.second);
-                bins.clear();
-                current_chr = chr;
-            }
+            size_t kll_items = coverage_sketch.get_num_retained();
+            size_t kll_mem   = coverage_sketch.get_serialized_size_bytes();
 
-            int start = aln->core.pos;
-            int end   = bam_endpos(aln);
+            csv << bin_size << ","
+                << total_bins << ","
+                << p25 << ","
+                << p50 << ","
+                << p75 << ","
+                << p95 << ","
+                << kll_items << ","
+                << K << ","
+                << kll_time << ","
+                << kll_mem << "\n";
 
-            for (int p = start; p < end; p += bin_size) {
-                bins[p / bin_size]++;
-            }
+            std::cout << "Mediana: " << p50 << "×\n";
+            std::cout << "KLL items: " << kll_items << "\n";
+            std::cout << "Memoria KLL: " << kll_mem / 1024.0 << " KB\n";
+            std::cout << "Tiempo KLL: " << kll_time << " s\n";
         }
-
-        // --- Timing KLL ---
-        auto t1 = hr_clock::now();
-        for (const auto& e : bins)
-            coverage_sketch.update((float)e.second);
-        auto t2 = hr_clock::now();
-
-        double kll_time =
-            std::chrono::duration<double>(t2 - t1).count();
-
-        float p25 = coverage_sketch.get_quantile(0.25);
-        float p50 = coverage_sketch.get_quantile(0.50);
-        float p75 = coverage_sketch.get_quantile(0.75);
-        float p95 = coverage_sketch.get_quantile(0.95);
-
-        size_t kll_items = coverage_sketch.get_num_retained();
-        size_t kll_mem   = coverage_sketch.get_serialized_size_bytes();
-
-        csv << bin_size << ","
-            << total_bins << ","
-            << p25 << ","
-            << p50 << ","
-            << p75 << ","
-            << p95 << ","
-            << kll_items << ","
-            << K << ","
-            << kll_time << ","
-            << kll_mem << "\n";
-
-        std::cout << "Mediana: " << p50 << "×\n";
-        std::cout << "KLL items: " << kll_items << "\n";
-        std::cout << "Memoria KLL: " << kll_mem / 1024.0 << " KB\n";
-        std::cout << "Tiempo KLL: " << kll_time << " s\n";
-
-        bam_destroy1(aln);
-        sam_hdr_destroy(header);
-        sam_close(bam_fp);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
     }
 
     csv.close();
@@ -1,192 +1,78 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <iomanip>
-#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 
-#include <htslib/sam.h>
+#include "alloc_counter.hpp"
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "cnv_segmenter.hpp"
+#include "csv_io.hpp"
+#include "result_cache.hpp"
 
-/*
- * ============================
- *   Estructuras de datos
- * ============================
- */
-
-struct BaselineStats {
-    int bin_size;
-    float p25;
-    float p50;
-    float p75;
-    float iqr;
-    float deletion_threshold;
-    float duplication_threshold;
-};
-
-struct CNV {
-    std::string chr;
-    uint64_t start;
-    uint64_t end;
-    std::string type;  // "DEL" o "DUP"
-    float mean_coverage;
-    uint64_t num_bins;
-};
+using namespace cnv;
 
 /*
  * ============================
- *   Utilidades
+ *   MAIN
  * ============================
  */
 
-BaselineStats load_baseline(const std::string& csv_file, int bin_size) {
-    std::ifstream in(csv_file);
-    if (!in.is_open())
-        throw std::runtime_error("No se pudo abrir baseline CSV");
-
-    std::string line;
-    std::getline(in, line); // header
-
-    while (std::getline(in, line)) {
-        std::stringstream ss(line);
-        std::string field;
-        BaselineStats b{};
-
-        // bin_size
-        std::getline(ss, field, ',');
-        b.bin_size = std::stoi(field);
-        if (b.bin_size != bin_size)
-            continue;
-
-        // total_bins (skip)
-        std::getline(ss, field, ',');
-
-        // p1, p5 (skip)
-        std::getline(ss, field, ',');
-        std::getline(ss, field, ',');
-
-        // p25, p50, p75
-        std::getline(ss, field, ','); b.p25 = std::stof(field);
-        std::getline(ss, field, ','); b.p50 = std::stof(field);
-        std::getline(ss, field, ','); b.p75 = std::stof(field);
-
-        // p95, p99 (skip)
-        std::getline(ss, field, ',');
-        std::getline(ss, field, ',');
-
-        // min, max (skip)
-        std::getline(ss, field, ',');
-        std::getline(ss, field, ',');
-
-        // iqr
-        std::getline(ss, field, ','); b.iqr = std::stof(field);
-
-        // deletion_threshold, duplication_threshold
-        std::getline(ss, field, ','); b.deletion_threshold = std::stof(field);
-        std::getline(ss, field, ','); b.duplication_threshold = std::stof(field);
-
-        return b;
-    }
-
-    throw std::runtime_error("Bin size no encontrado en baseline CSV");
-}
-
-
 /*
  * ============================
- *   Detección de CNVs
+ *   Entrada desde cache de cobertura (--coverage)
  * ============================
+ *
+ * Segmenta la cobertura por bin de un .cov (por ejemplo, el de
+ * generador_sintetico --output cache) sin abrir ningún BAM. Devuelve
+ * la cantidad de llamadas.
  */
 
-void detect_cnvs_for_chr(
-    const std::string& chr,
-    const std::unordered_map<uint32_t, uint32_t>& bins,
-    const BaselineStats& base,
-    std::vector<CNV>& cnvs
-) {
-    uint32_t run_start_bin = 0;
-    uint32_t run_len = 0;
-    uint64_t run_sum = 0;
-    std::string run_type;
-
-    auto flush_run = [&](uint32_t end_bin) {
-        if (run_len == 0) return;
-
-        CNV cnv;
-        cnv.chr = chr;
-        cnv.start = uint64_t(run_start_bin) * base.bin_size;
-        cnv.end   = uint64_t(end_bin + 1) * base.bin_size;
-        cnv.type  = run_type;
-        cnv.num_bins = run_len;
-        cnv.mean_coverage = float(run_sum) / run_len;
-
-        cnvs.push_back(cnv);
-
-        run_len = 0;
-        run_sum = 0;
-        run_type.clear();
-    };
-
-    std::vector<std::pair<uint32_t, uint32_t>> sorted_bins(
-    bins.begin(), bins.end()
-);
-
-    std::sort(sorted_bins.begin(), sorted_bins.end(),
-            [](auto& a, auto& b) {
-                return a.first < b.first;
-            });
-
-
-    for (const auto& e : bins) {
-        uint32_t bin = e.first;
-        uint32_t cov = e.second;
-
-        std::string current_type;
-
-        if (cov < base.deletion_threshold)
-            current_type = "DEL";
-        else if (cov > base.duplication_threshold)
-            current_type = "DUP";
-        else {
-            flush_run(bin - 1);
-            continue;
-        }
-
-        if (run_len == 0) {
-            run_start_bin = bin;
-            run_len = 1;
-            run_sum = cov;
-            run_type = current_type;
-        }
-        else if (current_type == run_type && bin == run_start_bin + run_len) {
-            run_len++;
-            run_sum += cov;
-        }
-        else {
-            flush_run(bin - 1);
-            run_start_bin = bin;
-            run_len = 1;
-            run_sum = cov;
-            run_type = current_type;
-        }
+uint64_t cnvs_from_coverage(const std::string& cov_file, int bin_size,
+                            const BaselineStats& base, std::ofstream& out, int min_bins) {
+    int cov_bin_size = 0;
+    std::vector<CoverageContig> contigs = read_coverage_cache(cov_file, cov_bin_size);
+    if (cov_bin_size != bin_size)
+        throw std::runtime_error(cov_file + " tiene bin size " + std::to_string(cov_bin_size) +
+                                 ", no " + std::to_string(bin_size));
+
+    // Los tids son el orden de los contigs en el archivo
+    std::vector<const char*> names;
+    for (const CoverageContig& c : contigs)
+        names.push_back(c.name.c_str());
+
+    CallArena calls;
+    uint64_t total_cnvs = 0;
+
+    for (size_t tid = 0; tid < contigs.size(); ++tid) {
+        calls.reset();
+        detect_cnvs_for_chr(int32_t(tid), contigs[tid].counts, 0, base, calls);
+        total_cnvs += calls.size();
+        write_cnvs(out, calls, min_bins, names.data());
     }
 
-    if (run_len > 0)
-        flush_run(run_start_bin + run_len - 1);
+    return total_cnvs;
 }
 
-/*
- * ============================
- *   MAIN
- * ============================
- */
-
 int main(int argc, char* argv[]) {
 
-    if (argc != 6) {
-        std::cerr << "Uso: " << argv[0]
-                  << " <archivo.bam> <bin_size> <baseline.csv> <output_cnvs.csv> <min_bins>\n";
+    // --coverage <archivo.cov> reemplaza al BAM como primer argumento
+    const char* prog = argv[0];
+    bool from_coverage = argc > 1 && std::string(argv[1]) == "--coverage";
+    if (from_coverage) {
+        argv++;
+        argc--;
+    }
+
+    if ((argc != 6 && !(argc == 8 && std::string(argv[6]) == "--cache")) ||
+        (from_coverage && argc != 6)) {
+        std::cerr << "Uso: " << prog
+                  << " <archivo.bam> <bin_size> <baseline.csv> <output_cnvs.csv> <min_bins>"
+                  << " [--cache <dir>]\n"
+                  << "     " << prog
+                  << " --coverage <archivo.cov> <bin_size> <baseline.csv> <output_cnvs.csv> <min_bins>\n";
         return 1;
     }
 
@@ -195,85 +81,122 @@ int main(int argc, char* argv[]) {
     std::string baseline_csv = argv[3];
     std::string output_csv = argv[4];
     int min_bins = std::atoi(argv[5]);
+    std::string cache_dir = argc == 8 ? argv[7] : "";
 
-    // --- Leer baseline ---
-    BaselineStats base = load_baseline(baseline_csv, bin_size);
+    try {
+        // --- Leer baseline ---
+        BaselineStats base = load_baseline(baseline_csv, bin_size);
 
-    // --- Abrir BAM ---
-    samFile* bam_fp = sam_open(bam_file, "r");
-    if (!bam_fp) {
-        std::cerr << "Error abriendo BAM\n";
-        return 1;
-    }
-
-    sam_hdr_t* header = sam_hdr_read(bam_fp);
-    bam1_t* aln = bam_init1();
-
-    std::string current_chr;
-    std::unordered_map<uint32_t, uint32_t> bins;
-    bins.reserve(100000);
+        if (from_coverage) {
+            std::ofstream out(output_csv);
+            if (!out)
+                throw std::runtime_error("No se pudo crear " + output_csv);
+            write_cnvs_header(out);
 
-    std::vector<CNV> cnvs;
+            uint64_t total_cnvs = cnvs_from_coverage(bam_file, bin_size, base, out, min_bins);
+            std::cout << "CNVs: " << total_cnvs << "\n";
+            return 0;
+        }
 
-    // --- Lectura BAM ---
-    while (sam_read1(bam_fp, header, aln) >= 0) {
+        // --- Abrir BAM ---
+        BamScanner bam(bam_file);
+        const char* const* names = bam.header()->target_name;
+
+        // --- Salida: cada cromosoma se escribe apenas termina ---
+        std::ofstream out(output_csv);
+        if (!out)
+            throw std::runtime_error("No se pudo crear " + output_csv);
+        write_cnvs_header(out);
+
+        // Buffers reservados una sola vez y reutilizados entre cromosomas
+        CoverageBinner binner(bin_size);
+        binner.reserve(bam.max_contig_length());
+        CallArena calls;
+
+        uint64_t total_reads = 0, total_cnvs = 0;
+        uint64_t allocs_start = heap_allocations();
+        uint64_t read_path_allocs = 0;
+
+        if (!cache_dir.empty()) {
+
+            // --- Lectura incremental: solo cromosomas cuyo digest cambió ---
+            ResultCache cache(cache_dir);
+            std::vector<uint64_t> digests = cache.input_digests(bam_file, bam.header());
+
+            int contigs = 0, calls_hits = 0, coverage_hits = 0;
+            std::vector<uint32_t> counts;
+
+            for (int tid = 0; tid < bam.num_contigs(); ++tid) {
+                if (bam.mapped_reads(tid) == 0)
+                    continue;
+
+                contigs++;
+                std::string name = bam.contig_name(tid);
+                uint64_t cov_key = coverage_key(digests[tid], bin_size, DEFAULT_EXCLUDE_FLAGS);
+                uint64_t cnv_key = calls_key(cov_key, base);
+
+                calls.reset();
+                if (cache.load_calls(name, cnv_key, tid, calls)) {
+                    calls_hits++;
+                }
+                else {
+                    if (load_or_scan_coverage(cache, bam, tid, cov_key,
+                                              DEFAULT_EXCLUDE_FLAGS, binner, counts))
+                        coverage_hits++;
+
+                    detect_cnvs_for_chr(tid, counts, 0, base, calls);
+                    cache.save_calls(name, cnv_key, calls, names);
+                }
+
+                total_cnvs += calls.size();
+                write_cnvs(out, calls, min_bins, names);
+            }
+
+            std::cout << "Cache " << cache_dir << ": " << contigs << " cromosomas, "
+                      << calls_hits << " llamadas reutilizadas, "
+                      << coverage_hits << " coberturas reutilizadas, "
+                      << contigs - calls_hits - coverage_hits << " leídos del BAM\n";
+        }
+        else {
 
-        if (aln->core.flag & (BAM_FUNMAP |
-                              BAM_FSECONDARY |
-                              BAM_FSUPPLEMENTARY |
-                              BAM_FDUP))
-            continue;
+            // --- Lectura BAM ---
+            // Las asignaciones del cierre de cromosoma (segmentación y
+            // escritura) se descuentan para medir solo el camino por read
+            uint64_t flush_allocs = 0;
 
-        std::string chr = header->target_name[aln->core.tid];
-        
+            total_reads = bam.scan(DEFAULT_EXCLUDE_FLAGS,
+                [&](int, int64_t start, int64_t end) { binner.add(start, end); },
+                [&](int tid) {
+                    uint64_t before = heap_allocations();
 
-        if (current_chr.empty())
-            current_chr = chr;
+                    calls.reset();
+                    detect_cnvs_for_chr(tid, binner.counts(), binner.first_bin(), base, calls);
+                    total_cnvs += calls.size();
+                    write_cnvs(out, calls, min_bins, names);
+                    binner.clear();
 
-        if (chr != current_chr) {
-            detect_cnvs_for_chr(current_chr, bins, base, cnvs);
-            bins.clear();
-            current_chr = chr;
+                    flush_allocs += heap_allocations() - before;
+                });
 
+            read_path_allocs = heap_allocations() - allocs_start - flush_allocs;
         }
 
-        int start = aln->core.pos;
-        int end   = bam_endpos(aln);
-
-        for (int p = start; p < end; p += bin_size) {
-            uint32_t bin = p / bin_size;
-            bins[bin]++;
-        }
+        out.close();
+
+        // --- Reporte ---
+        if (total_reads > 0)
+            std::cout << "Reads: " << total_reads << ", ";
+        std::cout << "CNVs: " << total_cnvs << "\n";
+        std::cout << "Asignaciones heap: " << heap_allocations() - allocs_start;
+        if (total_reads > 0)
+            std::cout << " (camino por read: " << read_path_allocs << ", "
+                      << double(read_path_allocs) / total_reads << " por read)";
+        std::cout << "\n";
     }
-
-    
-    // Flush final
-    detect_cnvs_for_chr(current_chr, bins, base, cnvs);
-
-    bam_destroy1(aln);
-    sam_hdr_destroy(header);
-    sam_close(bam_fp);
-
-    // --- Guardar CNVs ---
-    std::ofstream out(output_csv);
-    out << "chr,start,end,type,mean_coverage,num_bins\n";
-
-    for (const auto& c : cnvs) {
-        if (c.num_bins < (uint64_t)min_bins)
-            continue;
-
-        out << c.chr << ","
-            << c.start << ","
-            << c.end << ","
-            << c.type << ","
-            << std::fixed << std::setprecision(2)
-            << c.mean_coverage << ","
-            << c.num_bins << "\n";
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
     }
 
-    
-
-    out.close();
-
     return 0;
 }
@@ -0,0 +1,418 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <filesystem>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "quantile_backend.hpp"
+#include "cnv_segmenter.hpp"
+#include "csv_io.hpp"
+#include "shard_plan.hpp"
+
+using namespace cnv;
+
+/*
+ * ============================
+ *   Shard y reduce
+ * ============================
+ *
+ * Reparte un BAM indexado entre varios procesos que comparten un
+ * directorio. Flujo completo (cada "shard" puede correr en paralelo):
+ *
+ *   1. shard i n dir                  cobertura, sketch KLL y meta
+ *   2. reduce ... --baseline-out b    une los sketches: fila de baseline
+ *   3. shard i n dir --baseline b     rachas de CNV (reusa la cobertura)
+ *   4. reduce ... --cnvs-out c m      une las rachas cortadas: CNVs
+ *
+ * Los archivos de cada shard (shard_<i>_of_<n>.*) se escriben con un
+ * nombre temporal y se renombran al terminar, así el reduce nunca ve
+ * uno a medio escribir.
+ */
+
+void commit_file(const std::string& tmp, const std::string& path) {
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("No se pudo renombrar " + tmp + " a " + path);
+}
+
+struct ShardMeta {
+    uint64_t reads = 0;
+    double kll_time_sec = 0.0;
+};
+
+void write_meta(const std::string& path, const ShardMeta& meta) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        out << "reads,kll_time_sec\n" << meta.reads << "," << meta.kll_time_sec << "\n";
+        if (!out)
+            throw std::runtime_error("No se pudo escribir " + tmp);
+    }
+    commit_file(tmp, path);
+}
+
+ShardMeta read_meta(const std::string& path) {
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("No se pudo abrir " + path);
+
+    std::string line, token;
+    std::getline(in, line); // header
+    std::getline(in, line);
+
+    std::stringstream ss(line);
+    ShardMeta meta;
+    std::getline(ss, token, ','); meta.reads = std::stoull(token);
+    std::getline(ss, token, ','); meta.kll_time_sec = std::stod(token);
+    return meta;
+}
+
+// --k: mismo rango que kll_bam_reader
+bool parse_k(const char* arg, int& k) {
+    char* endp = nullptr;
+    long v = std::strtol(arg, &endp, 10);
+    if (endp == arg || *endp != '\0' || v < 8 || v > 65535) {
+        std::cerr << "--k debe ser un entero en [8, 65535]: " << arg << "\n";
+        return false;
+    }
+    k = int(v);
+    return true;
+}
+
+/*
+ * ============================
+ *   shard
+ * ============================
+ */
+
+// Lee del BAM las porciones del shard y guarda .cov, .kll y .meta
+std::vector<std::vector<uint32_t>> scan_pieces(
+    BamScanner& bam,
+    const std::vector<ShardPiece>& pieces,
+    int bin_size,
+    int k,
+    const std::string& dir,
+    int index,
+    int count
+) {
+    using clock = std::chrono::steady_clock;
+    std::chrono::duration<double> kll_time{0};
+
+    CoverageBinner binner(bin_size);
+    CoverageSketch sketch(k);
+    ShardMeta meta;
+
+    std::string cov_path = shard_path(dir, index, count, ".cov");
+    CoverageCacheWriter writer(cov_path + ".tmp", bin_size, pieces.size());
+
+    std::vector<std::vector<uint32_t>> slices;
+    slices.reserve(pieces.size());
+
+    for (const ShardPiece& p : pieces) {
+        int64_t beg = p.first_bin * bin_size;
+        int64_t end;
+
+        // La última porción del cromosoma no se recorta arriba: los reads
+        // que pasan el largo del contig suman bins igual que en la pasada
+        // completa
+        if (p.contig_end) {
+            binner.reset_from(p.first_bin, p.n_bins);
+            end = bam.contig_length(p.tid);
+        }
+        else {
+            binner.reset_window(p.first_bin, p.n_bins);
+            end = (p.first_bin + p.n_bins) * bin_size;
+        }
+
+        meta.reads += bam.scan_region(p.tid, beg, end, DEFAULT_EXCLUDE_FLAGS,
+            [&](int, int64_t start, int64_t read_end) { binner.add(start, read_end); });
+
+        auto t1 = clock::now();
+        update_sketch(sketch, binner.counts());
+        auto t2 = clock::now();
+        kll_time += (t2 - t1);
+
+        writer.write(bam.contig_name(p.tid), bam.contig_length(p.tid), binner.counts());
+        slices.push_back(binner.counts());
+    }
+
+    writer.close();
+    commit_file(cov_path + ".tmp", cov_path);
+
+    std::string kll_path = shard_path(dir, index, count, ".kll");
+    {
+        std::ofstream out(kll_path + ".tmp", std::ios::binary);
+        sketch.serialize(out);
+        if (!out)
+            throw std::runtime_error("No se pudo escribir " + kll_path + ".tmp");
+    }
+    commit_file(kll_path + ".tmp", kll_path);
+
+    meta.kll_time_sec = kll_time.count();
+    write_meta(shard_path(dir, index, count, ".meta"), meta);
+
+    std::cout << "Shard " << index << "/" << count << ": " << pieces.size()
+              << " porciones, " << meta.reads << " reads leídos\n";
+    return slices;
+}
+
+// Cobertura del shard desde su .cov si coincide con el reparto actual
+bool load_pieces(
+    const BamScanner& bam,
+    const std::vector<ShardPiece>& pieces,
+    int bin_size,
+    const std::string& cov_path,
+    std::vector<std::vector<uint32_t>>& slices
+) {
+    std::ifstream check(cov_path);
+    if (!check.good())
+        return false;
+    check.close();
+
+    int cached_bin_size = 0;
+    std::vector<CoverageContig> contigs = read_coverage_cache(cov_path, cached_bin_size);
+    if (cached_bin_size != bin_size || contigs.size() != pieces.size())
+        return false;
+
+    for (size_t i = 0; i < pieces.size(); ++i)
+        if (contigs[i].name != bam.contig_name(pieces[i].tid) ||
+            contigs[i].counts.size() < size_t(pieces[i].n_bins))
+            return false;
+
+    slices.clear();
+    for (CoverageContig& c : contigs)
+        slices.push_back(std::move(c.counts));
+    return true;
+}
+
+int run_shard(int argc, char* argv[]) {
+
+    if (argc < 7) {
+        std::cerr << "Uso: " << argv[0] << " shard"
+                  << " <archivo.bam> <bin_size> <indice> <n_shards> <dir>"
+                  << " [--k <K>] [--baseline <baseline.csv>]\n";
+        return 1;
+    }
+
+    const char* bam_file = argv[2];
+    int bin_size = std::atoi(argv[3]);
+    int index = std::atoi(argv[4]);
+    int count = std::atoi(argv[5]);
+    std::string dir = argv[6];
+    std::string baseline_csv;
+    int k = DEFAULT_K;
+
+    for (int i = 7; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--baseline" && i + 1 < argc)
+            baseline_csv = argv[++i];
+        else if (opt == "--k" && i + 1 < argc) {
+            if (!parse_k(argv[++i], k))
+                return 1;
+        }
+        else {
+            std::cerr << "Opción desconocida: " << opt << "\n";
+            return 1;
+        }
+    }
+
+    std::filesystem::create_directories(dir);
+
+    BamScanner bam(bam_file);
+    std::vector<ShardPiece> pieces = plan_shard(bam.header(), bin_size, index, count);
+
+    // --- Cobertura: del .cov del shard o leyendo sus regiones del BAM ---
+    std::vector<std::vector<uint32_t>> slices;
+    if (baseline_csv.empty() ||
+        !load_pieces(bam, pieces, bin_size, shard_path(dir, index, count, ".cov"), slices))
+        slices = scan_pieces(bam, pieces, bin_size, k, dir, index, count);
+
+    if (baseline_csv.empty())
+        return 0;
+
+    // --- Rachas de CNV por porción, con su suma de cobertura ---
+    BaselineStats base = load_baseline(baseline_csv, bin_size);
+    CallArena calls;
+    std::vector<CallRun> runs;
+
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        const ShardPiece& p = pieces[i];
+        const std::vector<uint32_t>& counts = slices[i];
+
+        calls.reset();
+        detect_cnvs_for_chr(p.tid, counts, p.first_bin, base, calls);
+
+        calls.for_each([&](const CNV& c) {
+            int64_t start_bin = int64_t(c.start / bin_size);
+            uint64_t sum = 0;
+            for (uint64_t b = 0; b < c.num_bins; ++b)
+                sum += counts[start_bin - p.first_bin + b];
+            runs.push_back({c.tid, start_bin, c.num_bins, sum, c.type});
+        });
+    }
+
+    std::string runs_path = shard_path(dir, index, count, ".runs");
+    write_runs(runs_path + ".tmp", runs);
+    commit_file(runs_path + ".tmp", runs_path);
+
+    std::cout << "Shard " << index << "/" << count << ": " << runs.size() << " rachas\n";
+    return 0;
+}
+
+/*
+ * ============================
+ *   reduce
+ * ============================
+ */
+
+int run_reduce(int argc, char* argv[]) {
+
+    auto usage = [&]() {
+        std::cerr << "Uso: " << argv[0] << " reduce"
+                  << " <archivo.bam> <bin_size> <n_shards> <dir> [--k <K>]"
+                  << " [--baseline-out <baseline.csv>]"
+                  << " [--cnvs-out <output_cnvs.csv> <min_bins>]\n";
+        return 1;
+    };
+
+    if (argc < 6)
+        return usage();
+
+    const char* bam_file = argv[2];
+    int bin_size = std::atoi(argv[3]);
+    int count = std::atoi(argv[4]);
+    std::string dir = argv[5];
+    std::string baseline_out, cnvs_out;
+    int min_bins = 0;
+    int k = DEFAULT_K;
+
+    for (int i = 6; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--baseline-out" && i + 1 < argc)
+            baseline_out = argv[++i];
+        else if (opt == "--k" && i + 1 < argc) {
+            if (!parse_k(argv[++i], k))
+                return 1;
+        }
+        else if (opt == "--cnvs-out" && i + 2 < argc) {
+            cnvs_out = argv[++i];
+            min_bins = std::atoi(argv[++i]);
+        }
+        else {
+            std::cerr << "Opción desconocida: " << opt << "\n";
+            return 1;
+        }
+    }
+
+    if (baseline_out.empty() && cnvs_out.empty())
+        return usage();
+    if (count <= 0) {
+        std::cerr << "n_shards debe ser positivo\n";
+        return 1;
+    }
+
+    // Solo se usa el header: nombres y largos de los cromosomas
+    BamScanner bam(bam_file);
+
+    if (!baseline_out.empty()) {
+
+        // --- Sketch global = unión de los sketches de cada shard ---
+        using clock = std::chrono::steady_clock;
+        CoverageSketch sketch(k);
+        uint64_t reads = 0;
+        double kll_time = 0.0;
+
+        for (int i = 0; i < count; ++i) {
+            std::string kll_path = shard_path(dir, i, count, ".kll");
+            std::ifstream in(kll_path, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("Falta el sketch del shard " + std::to_string(i) +
+                                         " (" + kll_path + ")");
+
+            CoverageSketch shard_sketch = CoverageSketch::deserialize(in);
+
+            // Unir sketches de distinto K daría una fila de baseline
+            // con un kll_k que no corresponde a ningún shard
+            if (shard_sketch.get_k() != k)
+                throw std::runtime_error("El sketch del shard " + std::to_string(i) +
+                                         " tiene K=" + std::to_string(shard_sketch.get_k()) +
+                                         ", no " + std::to_string(k) +
+                                         " (usar el mismo --k en shard y reduce)");
+            ShardMeta meta = read_meta(shard_path(dir, i, count, ".meta"));
+            reads += meta.reads;
+            kll_time += meta.kll_time_sec;
+
+            auto t1 = clock::now();
+            sketch.merge(shard_sketch);
+            auto t2 = clock::now();
+            kll_time += std::chrono::duration<double>(t2 - t1).count();
+        }
+
+        BaselineRow row = make_baseline_row(sketch, bin_size, bam.total_bins(bin_size), kll_time);
+        append_baseline_row(baseline_out, row);
+
+        std::cout << "Reduce: " << count << " shards, " << reads << " reads, "
+                  << sketch.get_n() << " bins en el sketch\n";
+    }
+
+    if (!cnvs_out.empty()) {
+
+        // --- Rachas de todos los shards en orden genómico ---
+        std::vector<CallRun> runs;
+        for (int i = 0; i < count; ++i) {
+            std::string runs_path = shard_path(dir, i, count, ".runs");
+            std::ifstream check(runs_path);
+            if (!check.good())
+                throw std::runtime_error("Faltan las rachas del shard " + std::to_string(i) +
+                                         " (" + runs_path + ")");
+            check.close();
+
+            std::vector<CallRun> shard_runs = read_runs(runs_path);
+            runs.insert(runs.end(), shard_runs.begin(), shard_runs.end());
+        }
+
+        CallArena calls;
+        stitch_runs(runs, bin_size, calls);
+
+        std::ofstream out(cnvs_out);
+        if (!out)
+            throw std::runtime_error("No se pudo crear " + cnvs_out);
+        write_cnvs_header(out);
+        write_cnvs(out, calls, min_bins, bam.header()->target_name);
+
+        std::cout << "Reduce: " << runs.size() << " rachas, "
+                  << runs.size() - calls.size() << " uniones en bordes de shard, "
+                  << calls.size() << " CNVs\n";
+    }
+
+    return 0;
+}
+
+/*
+ * ============================
+ *   MAIN
+ * ============================
+ */
+
+int main(int argc, char* argv[]) {
+
+    std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd != "shard" && cmd != "reduce") {
+        std::cerr << "Uso: " << argv[0] << " shard|reduce ...\n";
+        return 1;
+    }
+
+    try {
+        return cmd == "shard" ? run_shard(argc, argv) : run_reduce(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * ============================
+ *   Contador de asignaciones
+ * ============================
+ *
+ * alloc_counter.cpp reemplaza el operator new global y cuenta cada
+ * llamada. No es parte de cnv_core: solo lo enlaza cnv_pasada
+ * (cnv_alloc_counter en CMakeLists.txt), para que el resto de los
+ * programas y los benchmarks no paguen el incremento atómico. Sirve
+ * para verificar que el camino por read no reserva memoria en régimen
+ * estable. No ve los malloc internos de htslib (por ejemplo, al crecer
+ * bam1_t).
+ */
+
+namespace cnv {
+
+uint64_t heap_allocations();
+
+} // namespace cnv
@@ -0,0 +1,68 @@
+#include "bam_scanner.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cnv {
+
+BamScanner::BamScanner(const std::string& bam_file) : path_(bam_file) {
+    fp_ = sam_open(bam_file.c_str(), "r");
+    if (!fp_)
+        throw std::runtime_error("No se pudo abrir el BAM " + bam_file);
+
+    header_ = sam_hdr_read(fp_);
+    if (!header_) {
+        sam_close(fp_);
+        throw std::runtime_error("Error leyendo header de " + bam_file);
+    }
+
+    aln_ = bam_init1();
+}
+
+BamScanner::~BamScanner() {
+    if (idx_)
+        hts_idx_destroy(idx_);
+    bam_destroy1(aln_);
+    sam_hdr_destroy(header_);
+    sam_close(fp_);
+}
+
+uint64_t BamScanner::total_bins(int bin_size) const {
+    uint64_t total = 0;
+    for (int i = 0; i < header_->n_targets; ++i) {
+        uint64_t chr_len = header_->target_len[i];
+        total += (chr_len + bin_size - 1) / bin_size;
+    }
+    return total;
+}
+
+int64_t BamScanner::max_contig_length() const {
+    int64_t max_len = 0;
+    for (int i = 0; i < header_->n_targets; ++i)
+        max_len = std::max<int64_t>(max_len, header_->target_len[i]);
+    return max_len;
+}
+
+hts_idx_t* BamScanner::index() {
+    if (!idx_loaded_) {
+        idx_ = sam_index_load(fp_, path_.c_str());
+        idx_loaded_ = true;
+    }
+    return idx_;
+}
+
+uint64_t BamScanner::mapped_reads(int tid) {
+    uint64_t mapped = 0, unmapped = 0;
+    if (hts_idx_get_stat(index_or_throw(), tid, &mapped, &unmapped) < 0)
+        return 0;
+    return mapped;
+}
+
+hts_idx_t* BamScanner::index_or_throw() {
+    hts_idx_t* idx = index();
+    if (!idx)
+        throw std::runtime_error("No se encontró el índice .bai de " + path_);
+    return idx;
+}
+
+} // namespace cnv
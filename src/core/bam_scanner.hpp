@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <htslib/sam.h>
+
+/*
+ * ============================
+ *   Lector de BAM compartido
+ * ============================
+ *
+ * Encapsula la apertura del BAM, el filtro por flags y la detección de
+ * cambio de cromosoma que antes repetía cada programa. El recorrido se
+ * hace con callbacks plantilla para que el bucle por read quede inline
+ * en cada front-end.
+ */
+
+namespace cnv {
+
+// Flags descartados por defecto: no mapeados, secundarios, suplementarios
+// y duplicados.
+constexpr uint16_t DEFAULT_EXCLUDE_FLAGS =
+    BAM_FUNMAP | BAM_FSECONDARY | BAM_FSUPPLEMENTARY | BAM_FDUP;
+
+class BamScanner {
+public:
+    explicit BamScanner(const std::string& bam_file);
+    ~BamScanner();
+
+    BamScanner(const BamScanner&) = delete;
+    BamScanner& operator=(const BamScanner&) = delete;
+
+    const sam_hdr_t* header() const { return header_; }
+    int num_contigs() const { return header_->n_targets; }
+    const char* contig_name(int tid) const { return header_->target_name[tid]; }
+    int64_t contig_length(int tid) const { return header_->target_len[tid]; }
+
+    // Bins teóricos de todo el header (columna total_bins del baseline)
+    uint64_t total_bins(int bin_size) const;
+    // Largo del contig más grande; sirve para reservar buffers una sola vez
+    int64_t max_contig_length() const;
+
+    // Índice .bai/.csi; nullptr si no existe. Se carga una sola vez.
+    hts_idx_t* index();
+
+    // Reads mapeados según el índice (0 si el cromosoma no tiene datos)
+    uint64_t mapped_reads(int tid);
+
+    /*
+     * Recorre el BAM completo en orden. on_read(tid, start, end) recibe
+     * cada read que pasa el filtro y on_contig_end(tid) se llama al
+     * cambiar de cromosoma y al final. Devuelve el total de reads leídos,
+     * incluidos los filtrados.
+     */
+    template <typename OnRead, typename OnContigEnd>
+    uint64_t scan(uint16_t exclude_flags, OnRead&& on_read, OnContigEnd&& on_contig_end);
+
+    /*
+     * Reads que solapan [beg, end) en el cromosoma tid, vía índice.
+     * Lanza si el BAM no tiene índice.
+     */
+    template <typename OnRead>
+    uint64_t scan_region(int tid, int64_t beg, int64_t end,
+                         uint16_t exclude_flags, OnRead&& on_read);
+
+private:
+    hts_idx_t* index_or_throw();
+
+    std::string path_;
+    samFile* fp_ = nullptr;
+    sam_hdr_t* header_ = nullptr;
+    bam1_t* aln_ = nullptr;
+    hts_idx_t* idx_ = nullptr;
+    bool idx_loaded_ = false;
+};
+
+template <typename OnRead, typename OnContigEnd>
+uint64_t BamScanner::scan(uint16_t exclude_flags, OnRead&& on_read, OnContigEnd&& on_contig_end) {
+    uint64_t total_reads = 0;
+    int current_tid = -1;
+
+    while (sam_read1(fp_, header_, aln_) >= 0) {
+
+        total_reads++;
+
+        if (aln_->core.flag & exclude_flags)
+            continue;
+
+        int tid = aln_->core.tid;
+
+        if (tid != current_tid) {
+            if (current_tid >= 0)
+                on_contig_end(current_tid);
+            current_tid = tid;
+        }
+
+        on_read(tid, int64_t(aln_->core.pos), int64_t(bam_endpos(aln_)));
+    }
+
+    if (current_tid >= 0)
+        on_contig_end(current_tid);
+
+    return total_reads;
+}
+
+template <typename OnRead>
+uint64_t BamScanner::scan_region(int tid, int64_t beg, int64_t end,
+                                 uint16_t exclude_flags, OnRead&& on_read) {
+    hts_itr_t* itr = sam_itr_queryi(index_or_throw(), tid, beg, end);
+    if (!itr)
+        return 0;
+
+    uint64_t total_reads = 0;
+    while (sam_itr_next(fp_, itr, aln_) >= 0) {
+
+        total_reads++;
+
+        if (aln_->core.flag & exclude_flags)
+            continue;
+
+        on_read(tid, int64_t(aln_->core.pos), int64_t(bam_endpos(aln_)));
+    }
+
+    hts_itr_destroy(itr);
+    return total_reads;
+}
+
+} // namespace cnv
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * ============================
+ *   Llamadas de CNV
+ * ============================
+ *
+ * Una llamada identifica su cromosoma por el tid del header y su tipo
+ * por un enum: no lleva strings, así que crearla no reserva memoria.
+ * Los nombres se resuelven recién al escribir la salida.
+ */
+
+namespace cnv {
+
+enum class CnvType : uint8_t { DEL, DUP };
+
+inline const char* cnv_type_name(CnvType t) {
+    return t == CnvType::DEL ? "DEL" : "DUP";
+}
+
+struct CNV {
+    int32_t tid;
+    uint64_t start;
+    uint64_t end;
+    CnvType type;
+    float mean_coverage;
+    uint64_t num_bins;
+};
+
+/*
+ * Arena de llamadas de un cromosoma. Reserva bloques fijos que nunca
+ * se mueven ni se liberan al hacer reset(): tras el primer cromosoma
+ * con muchas llamadas, los siguientes reutilizan la misma memoria.
+ */
+class CallArena {
+public:
+    static constexpr size_t BLOCK_SIZE = 1024;
+
+    CNV& emplace() {
+        size_t block = size_ / BLOCK_SIZE;
+        if (block == blocks_.size())
+            blocks_.emplace_back(new CNV[BLOCK_SIZE]);
+        return blocks_[block][size_++ % BLOCK_SIZE];
+    }
+
+    // Vacía la arena conservando los bloques reservados
+    void reset() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const CNV& operator[](size_t i) const { return blocks_[i / BLOCK_SIZE][i % BLOCK_SIZE]; }
+    CNV& operator[](size_t i) { return blocks_[i / BLOCK_SIZE][i % BLOCK_SIZE]; }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (size_t i = 0; i < size_; ++i)
+            f((*this)[i]);
+    }
+
+private:
+    std::vector<std::unique_ptr<CNV[]>> blocks_;
+    size_t size_ = 0;
+};
+
+} // namespace cnv
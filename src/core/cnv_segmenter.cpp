@@ -0,0 +1,66 @@
+#include "cnv_segmenter.hpp"
+
+namespace cnv {
+
+void detect_cnvs_for_chr(
+    int32_t tid,
+    const std::vector<uint32_t>& counts,
+    int64_t first_bin,
+    const BaselineStats& base,
+    CallArena& calls
+) {
+    int64_t run_start_bin = 0;
+    uint64_t run_len = 0;
+    uint64_t run_sum = 0;
+    CnvType run_type = CnvType::DEL;
+
+    auto flush_run = [&]() {
+        if (run_len == 0) return;
+
+        CNV& cnv = calls.emplace();
+        cnv.tid = tid;
+        cnv.start = uint64_t(run_start_bin) * base.bin_size;
+        cnv.end   = uint64_t(run_start_bin + run_len) * base.bin_size;
+        cnv.type  = run_type;
+        cnv.num_bins = run_len;
+        cnv.mean_coverage = float(run_sum) / run_len;
+
+        run_len = 0;
+        run_sum = 0;
+    };
+
+    // Recorrido en orden de bin: una racha solo continúa si el bin es
+    // contiguo y del mismo tipo
+    for (size_t i = 0; i < counts.size(); ++i) {
+        uint32_t cov = counts[i];
+        if (cov == 0)
+            continue;
+
+        int64_t bin = first_bin + int64_t(i);
+        CnvType current_type;
+
+        if (cov < base.deletion_threshold)
+            current_type = CnvType::DEL;
+        else if (cov > base.duplication_threshold)
+            current_type = CnvType::DUP;
+        else {
+            flush_run();
+            continue;
+        }
+
+        if (run_len > 0 &&
+            (current_type != run_type || bin != run_start_bin + int64_t(run_len)))
+            flush_run();
+
+        if (run_len == 0) {
+            run_start_bin = bin;
+            run_type = current_type;
+        }
+        run_len++;
+        run_sum += cov;
+    }
+
+    flush_run();
+}
+
+} // namespace cnv
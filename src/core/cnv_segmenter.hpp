@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cnv_calls.hpp"
+#include "csv_io.hpp"
+
+/*
+ * ============================
+ *   Segmentación de CNVs
+ * ============================
+ *
+ * Agrupa bins consecutivos bajo el umbral de deleción o sobre el de
+ * duplicación en una misma llamada. Los bins en cero (sin reads) no
+ * se evalúan y cortan la racha, igual que cuando los bins vivían en
+ * un unordered_map.
+ */
+
+namespace cnv {
+
+// counts[i] es la cobertura del bin first_bin + i del cromosoma tid.
+// Las llamadas se agregan a la arena sin reservar memoria por llamada.
+void detect_cnvs_for_chr(
+    int32_t tid,
+    const std::vector<uint32_t>& counts,
+    int64_t first_bin,
+    const BaselineStats& base,
+    CallArena& calls
+);
+
+} // namespace cnv
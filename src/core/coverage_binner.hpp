@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+/*
+ * ============================
+ *   Binner de cobertura
+ * ============================
+ *
+ * Cuenta, para cada read [start, end), los bins visitados por el
+ * recorrido p = start; p < end; p += bin_size. Como
+ * (start + k * bin_size) / bin_size == start / bin_size + k, los bins
+ * tocados son consecutivos y el bucle no necesita dividir por paso.
+ *
+ * Los conteos se guardan en un vector denso por cromosoma en lugar de
+ * un unordered_map. Los bins en cero equivalen a los que el mapa nunca
+ * contenía: no se envían al sketch ni participan en la segmentación.
+ *
+ * En modo ventana solo se cuentan los bins [first_bin, first_bin + n),
+ * lo que permite muestrear o repartir el genoma por regiones y obtener
+ * exactamente los mismos conteos que la pasada completa.
+ */
+
+namespace cnv {
+
+class CoverageBinner {
+public:
+    explicit CoverageBinner(int bin_size) : bin_size_(bin_size) {}
+
+    int bin_size() const { return bin_size_; }
+
+    // Cromosoma completo: bins desde 0, crece si un read sobrepasa el largo
+    void reset(int64_t contig_length) {
+        first_bin_ = 0;
+        limit_bin_ = std::numeric_limits<int64_t>::max();
+        counts_.assign((contig_length + bin_size_ - 1) / bin_size_, 0);
+    }
+
+    // Cromosoma de largo aún desconocido: crece con los reads y conserva
+    // la memoria reservada por el cromosoma anterior
+    void clear() {
+        first_bin_ = 0;
+        limit_bin_ = std::numeric_limits<int64_t>::max();
+        counts_.clear();
+    }
+
+    // Reserva para el cromosoma más largo: después de esto ni reset() ni
+    // add() vuelven a pedir memoria mientras los reads caigan dentro
+    void reserve(int64_t max_contig_length) {
+        counts_.reserve((max_contig_length + bin_size_ - 1) / bin_size_);
+    }
+
+    // Ventana fija de n_bins bins a partir de first_bin
+    void reset_window(int64_t first_bin, int64_t n_bins) {
+        first_bin_ = first_bin;
+        limit_bin_ = first_bin + n_bins;
+        counts_.assign(n_bins, 0);
+    }
+
+    // Desde first_bin hasta el final del cromosoma: como reset(), pero
+    // ignorando los bins anteriores. Crece si un read sobrepasa el largo.
+    void reset_from(int64_t first_bin, int64_t n_bins) {
+        first_bin_ = first_bin;
+        limit_bin_ = std::numeric_limits<int64_t>::max();
+        counts_.assign(n_bins, 0);
+    }
+
+    void add(int64_t start, int64_t end) {
+        if (end <= start)
+            return;
+
+        int64_t lo = start / bin_size_;
+        int64_t hi = lo + (end - start + bin_size_ - 1) / bin_size_;
+
+        lo = std::max(lo, first_bin_);
+        hi = std::min(hi, limit_bin_);
+        if (lo >= hi)
+            return;
+
+        if (size_t(hi - first_bin_) > counts_.size())
+            counts_.resize(hi - first_bin_, 0);
+
+        uint32_t* c = counts_.data();
+        for (int64_t i = lo - first_bin_; i < hi - first_bin_; ++i)
+            c[i]++;
+    }
+
+    int64_t first_bin() const { return first_bin_; }
+    const std::vector<uint32_t>& counts() const { return counts_; }
+
+    // f(bin_absoluto, conteo) para cada bin con cobertura
+    template <typename F>
+    void for_each_nonzero(F&& f) const {
+        for (size_t i = 0; i < counts_.size(); ++i)
+            if (counts_[i] > 0)
+                f(first_bin_ + int64_t(i), counts_[i]);
+    }
+
+private:
+    int bin_size_;
+    int64_t first_bin_ = 0;
+    int64_t limit_bin_ = std::numeric_limits<int64_t>::max();
+    std::vector<uint32_t> counts_;
+};
+
+} // namespace cnv
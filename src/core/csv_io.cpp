@@ -0,0 +1,262 @@
+#include "csv_io.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace cnv {
+
+BaselineStats load_baseline(const std::string& csv_file, int bin_size) {
+    std::ifstream in(csv_file);
+    if (!in.is_open())
+        throw std::runtime_error("No se pudo abrir baseline CSV");
+
+    std::string line;
+    std::getline(in, line); // header
+
+    bool only_sampled = false;
+
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string field;
+        BaselineStats b{};
+
+        // bin_size
+        std::getline(ss, field, ',');
+        b.bin_size = std::stoi(field);
+        if (b.bin_size != bin_size)
+            continue;
+
+        // total_bins (skip)
+        std::getline(ss, field, ',');
+
+        // p1, p5 (skip)
+        std::getline(ss, field, ',');
+        std::getline(ss, field, ',');
+
+        // p25, p50, p75
+        std::getline(ss, field, ','); b.p25 = std::stof(field);
+        std::getline(ss, field, ','); b.p50 = std::stof(field);
+        std::getline(ss, field, ','); b.p75 = std::stof(field);
+
+        // p95, p99 (skip)
+        std::getline(ss, field, ',');
+        std::getline(ss, field, ',');
+
+        // min, max (skip)
+        std::getline(ss, field, ',');
+        std::getline(ss, field, ',');
+
+        // iqr
+        std::getline(ss, field, ','); b.iqr = std::stof(field);
+
+        // deletion_threshold, duplication_threshold
+        std::getline(ss, field, ','); b.deletion_threshold = std::stof(field);
+        std::getline(ss, field, ','); b.duplication_threshold = std::stof(field);
+
+        // kll_items, kll_k, kll_time_sec (skip)
+        std::getline(ss, field, ',');
+        std::getline(ss, field, ',');
+        std::getline(ss, field, ',');
+
+        // sample_fraction: una estimación muestreada no sirve de baseline
+        if (std::getline(ss, field, ',') && !field.empty() && std::stod(field) < 1.0) {
+            only_sampled = true;
+            continue;
+        }
+
+        return b;
+    }
+
+    if (only_sampled)
+        throw std::runtime_error("El baseline CSV solo tiene filas muestreadas para ese bin size; "
+                                 "correr kll_bam_reader sin --sample-fraction");
+    throw std::runtime_error("Bin size no encontrado en baseline CSV");
+}
+
+void append_baseline_row(const std::string& csv_file, const BaselineRow& row) {
+    bool write_header = false;
+    std::ifstream check(csv_file);
+    if (!check.good())
+        write_header = true;
+    check.close();
+
+    std::ofstream out(csv_file, std::ios::app);
+    out << std::fixed << std::setprecision(6);
+
+    if (write_header) {
+        out << "bin_size,"
+            << "total_bins,"
+            << "p1,p5,p25,p50,p75,p95,p99,"
+            << "min,max,iqr,"
+            << "deletion_threshold,duplication_threshold,"
+            << "kll_items,kll_k,kll_time_sec,"
+            << "sample_fraction\n";
+    }
+
+    out << row.bin_size << ","
+        << row.total_bins << ","
+        << row.p1 << "," << row.p5 << "," << row.p25 << "," << row.p50 << ","
+        << row.p75 << "," << row.p95 << "," << row.p99 << ","
+        << row.min << "," << row.max << ","
+        << row.iqr << ","
+        << row.deletion_threshold << ","
+        << row.duplication_threshold << ","
+        << row.kll_items << ","
+        << row.kll_k << ","
+        << row.kll_time_sec << ","
+        << row.sample_fraction << "\n";
+}
+
+std::vector<BinExperimentRow> load_bin_experiment(const std::string& csv_file) {
+    std::ifstream in(csv_file);
+    if (!in)
+        throw std::runtime_error("No se pudo abrir " + csv_file);
+
+    std::vector<BinExperimentRow> rows;
+
+    std::string line;
+    std::getline(in, line); // header
+
+    while (std::getline(in, line)) {
+
+        std::stringstream ss(line);
+        std::string token;
+        BinExperimentRow r{};
+
+        std::getline(ss, token, ','); r.bin_size = std::stoi(token);
+        std::getline(ss, token, ','); r.num_bins = std::stoull(token);
+        std::getline(ss, token, ','); r.p25 = std::stof(token);
+        std::getline(ss, token, ','); r.p50 = std::stof(token);
+        std::getline(ss, token, ','); r.p75 = std::stof(token);
+        std::getline(ss, token, ','); r.p95 = std::stof(token);
+        std::getline(ss, token, ','); r.kll_items = std::stoull(token);
+        std::getline(ss, token, ','); r.kll_k = std::stoi(token);
+        std::getline(ss, token, ','); r.kll_time_sec = std::stod(token);
+        std::getline(ss, token, ','); r.kll_memory_bytes = std::stoull(token);
+
+        rows.push_back(r);
+    }
+
+    return rows;
+}
+
+void read_cnvs(const std::string& csv_file, int32_t tid, CallArena& calls) {
+    std::ifstream in(csv_file);
+    if (!in)
+        throw std::runtime_error("No se pudo abrir " + csv_file);
+
+    std::string line;
+    std::getline(in, line); // header
+
+    while (std::getline(in, line)) {
+
+        std::stringstream ss(line);
+        std::string token;
+        CNV& c = calls.emplace();
+        c.tid = tid;
+
+        std::getline(ss, token, ','); // chr
+        std::getline(ss, token, ','); c.start = std::stoull(token);
+        std::getline(ss, token, ','); c.end = std::stoull(token);
+        std::getline(ss, token, ','); c.type = token == "DEL" ? CnvType::DEL : CnvType::DUP;
+        std::getline(ss, token, ','); c.mean_coverage = std::stof(token);
+        std::getline(ss, token, ','); c.num_bins = std::stoull(token);
+    }
+}
+
+void write_cnvs_header(std::ostream& out) {
+    out << "chr,start,end,type,mean_coverage,num_bins\n";
+}
+
+void write_cnvs(std::ostream& out, const CallArena& calls, uint64_t min_bins,
+                const char* const* contig_names) {
+    calls.for_each([&](const CNV& c) {
+        if (c.num_bins < min_bins)
+            return;
+
+        out << contig_names[c.tid] << ","
+            << c.start << ","
+            << c.end << ","
+            << cnv_type_name(c.type) << ","
+            << std::fixed << std::setprecision(2)
+            << c.mean_coverage << ","
+            << c.num_bins << "\n";
+    });
+}
+
+/*
+ * ============================
+ *   Cache de cobertura
+ * ============================
+ */
+
+namespace {
+
+constexpr char COVERAGE_MAGIC[8] = {'C', 'N', 'V', 'C', 'O', 'V', '1', '\n'};
+
+template <typename T>
+void write_pod(std::ofstream& out, T v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+T read_pod(std::ifstream& in) {
+    T v{};
+    in.read(reinterpret_cast<char*>(&v), sizeof(T));
+    return v;
+}
+
+} // namespace
+
+CoverageCacheWriter::CoverageCacheWriter(const std::string& path, int bin_size, uint32_t n_contigs)
+    : out_(path, std::ios::binary) {
+    if (!out_)
+        throw std::runtime_error("No se pudo crear " + path);
+
+    out_.write(COVERAGE_MAGIC, sizeof(COVERAGE_MAGIC));
+    write_pod<uint32_t>(out_, bin_size);
+    write_pod<uint32_t>(out_, n_contigs);
+}
+
+void CoverageCacheWriter::write(const std::string& name, uint64_t length,
+                                const std::vector<uint32_t>& counts) {
+    write_pod<uint32_t>(out_, name.size());
+    out_.write(name.data(), name.size());
+    write_pod<uint64_t>(out_, length);
+    write_pod<uint64_t>(out_, counts.size());
+    out_.write(reinterpret_cast<const char*>(counts.data()),
+               counts.size() * sizeof(uint32_t));
+}
+
+std::vector<CoverageContig> read_coverage_cache(const std::string& path, int& bin_size) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("No se pudo abrir " + path);
+
+    char magic[sizeof(COVERAGE_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, COVERAGE_MAGIC, sizeof(magic)) != 0)
+        throw std::runtime_error(path + " no es un cache de cobertura");
+
+    bin_size = read_pod<uint32_t>(in);
+    uint32_t n_contigs = read_pod<uint32_t>(in);
+
+    std::vector<CoverageContig> contigs(n_contigs);
+    for (auto& c : contigs) {
+        c.name.resize(read_pod<uint32_t>(in));
+        in.read(&c.name[0], c.name.size());
+        c.length = read_pod<uint64_t>(in);
+        c.counts.resize(read_pod<uint64_t>(in));
+        in.read(reinterpret_cast<char*>(c.counts.data()),
+                c.counts.size() * sizeof(uint32_t));
+    }
+
+    if (!in)
+        throw std::runtime_error(path + " está truncado");
+
+    return contigs;
+}
+
+} // namespace cnv
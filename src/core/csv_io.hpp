@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "cnv_calls.hpp"
+
+/*
+ * ============================
+ *   Entrada/salida CSV y cache
+ * ============================
+ */
+
+namespace cnv {
+
+// Subconjunto del baseline que usa la detección de CNVs
+struct BaselineStats {
+    int bin_size;
+    float p25;
+    float p50;
+    float p75;
+    float iqr;
+    float deletion_threshold;
+    float duplication_threshold;
+};
+
+// Fila completa del CSV de baseline (bam_reader_mejorado)
+struct BaselineRow {
+    int bin_size;
+    uint64_t total_bins;
+    float p1, p5, p25, p50, p75, p95, p99;
+    float min, max, iqr;
+    float deletion_threshold;
+    float duplication_threshold;
+    size_t kll_items;
+    int kll_k;
+    double kll_time_sec;
+    double sample_fraction;     // 1 = pasada completa; < 1 = modo muestreado
+};
+
+// Fila de bin_experiment.csv (cnv_kll_experimentacion)
+struct BinExperimentRow {
+    int bin_size;
+    uint64_t num_bins;
+    float p25, p50, p75, p95;
+    size_t kll_items;
+    int kll_k;
+    double kll_time_sec;
+    size_t kll_memory_bytes;
+};
+
+// Primera fila de pasada completa con el bin_size pedido; lanza si no
+// existe. Las filas con sample_fraction < 1 (estimaciones muestreadas) se
+// ignoran; las filas sin esa columna (CSV anteriores) cuentan como completas.
+BaselineStats load_baseline(const std::string& csv_file, int bin_size);
+
+// Agrega la fila al CSV, escribiendo el header si el archivo es nuevo
+void append_baseline_row(const std::string& csv_file, const BaselineRow& row);
+
+std::vector<BinExperimentRow> load_bin_experiment(const std::string& csv_file);
+
+// Agrega a calls las llamadas de un CSV de un solo cromosoma (tid)
+void read_cnvs(const std::string& csv_file, int32_t tid, CallArena& calls);
+
+void write_cnvs_header(std::ostream& out);
+// Escribe las llamadas con al menos min_bins bins; contig_names es
+// target_name del header y resuelve el tid de cada llamada
+void write_cnvs(std::ostream& out, const CallArena& calls, uint64_t min_bins,
+                const char* const* contig_names);
+
+/*
+ * Cache de cobertura por bin. Formato binario (little endian):
+ *   "CNVCOV1\n", uint32 bin_size, uint32 n_contigs
+ *   por contig: uint32 largo_nombre, nombre, uint64 largo,
+ *               uint64 n_bins, uint32 conteo[n_bins]
+ *
+ * Los bins en cero se guardan; al alimentar el sketch deben omitirse,
+ * igual que en la pasada sobre el BAM.
+ */
+
+struct CoverageContig {
+    std::string name;
+    uint64_t length;
+    std::vector<uint32_t> counts;
+};
+
+class CoverageCacheWriter {
+public:
+    CoverageCacheWriter(const std::string& path, int bin_size, uint32_t n_contigs);
+
+    void write(const std::string& name, uint64_t length, const std::vector<uint32_t>& counts);
+    void close() { out_.close(); }
+
+private:
+    std::ofstream out_;
+};
+
+// Lee el cache completo; lanza si el formato no es válido
+std::vector<CoverageContig> read_coverage_cache(const std::string& path, int& bin_size);
+
+} // namespace cnv
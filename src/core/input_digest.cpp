@@ -0,0 +1,214 @@
+#include "input_digest.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace cnv {
+
+std::string to_hex(uint64_t v) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+namespace {
+
+constexpr uint32_t BAI_PSEUDO_BIN = 37450;
+
+template <typename T>
+bool read_pod(std::ifstream& in, T& v) {
+    in.read(reinterpret_cast<char*>(&v), sizeof(T));
+    return bool(in);
+}
+
+std::string find_bai(const std::string& bam_file) {
+    std::string candidates[2] = { bam_file + ".bai", bam_file };
+    if (candidates[1].size() > 4 &&
+        candidates[1].compare(candidates[1].size() - 4, 4, ".bam") == 0)
+        candidates[1].replace(candidates[1].size() - 4, 4, ".bai");
+    else
+        candidates[1].clear();
+
+    for (const auto& c : candidates)
+        if (!c.empty() && std::ifstream(c).good())
+            return c;
+    return "";
+}
+
+/*
+ * Lee las secciones por referencia del .bai. Devuelve false si el
+ * archivo no tiene el formato esperado.
+ */
+bool digest_bai(const std::string& bai_file, const sam_hdr_t* header,
+                std::vector<uint64_t>& digests) {
+    std::ifstream in(bai_file, std::ios::binary);
+
+    char magic[4];
+    in.read(magic, 4);
+    if (!in || std::memcmp(magic, "BAI\1", 4) != 0)
+        return false;
+
+    int32_t n_ref;
+    if (!read_pod(in, n_ref) || n_ref != header->n_targets)
+        return false;
+
+    std::vector<uint32_t> bins;
+
+    for (int32_t r = 0; r < n_ref; ++r) {
+
+        uint64_t mapped = 0, unmapped = 0;
+
+        int32_t n_bin;
+        if (!read_pod(in, n_bin))
+            return false;
+
+        bins.clear();
+        for (int32_t b = 0; b < n_bin; ++b) {
+            uint32_t bin;
+            int32_t n_chunk;
+            if (!read_pod(in, bin) || !read_pod(in, n_chunk))
+                return false;
+
+            for (int32_t i = 0; i < n_chunk; ++i) {
+                uint64_t beg, end;
+                if (!read_pod(in, beg) || !read_pod(in, end))
+                    return false;
+
+                // Segundo par del pseudo-bin: reads mapeados / no mapeados
+                if (bin == BAI_PSEUDO_BIN && i == 1) {
+                    mapped = beg;
+                    unmapped = end;
+                }
+            }
+            if (bin != BAI_PSEUDO_BIN)
+                bins.push_back(bin);
+        }
+
+        // Los offsets del índice lineal dependen de los bloques BGZF;
+        // solo cuenta cuántas ventanas de 16 kb cubre
+        int32_t n_intv;
+        if (!read_pod(in, n_intv))
+            return false;
+        in.seekg(int64_t(n_intv) * sizeof(uint64_t), std::ios::cur);
+
+        // El orden de los bins en el .bai no es significativo
+        std::sort(bins.begin(), bins.end());
+
+        Digest d;
+        d.add(std::string(header->target_name[r]));
+        d.add(uint64_t(header->target_len[r]));
+        d.add(mapped);
+        d.add(unmapped);
+        d.add(uint64_t(n_intv));
+        for (uint32_t b : bins)
+            d.add(uint64_t(b));
+
+        digests[r] = d.value();
+    }
+
+    return bool(in);
+}
+
+std::vector<uint64_t> compute_digests(const std::string& bam_file, const sam_hdr_t* header) {
+    std::vector<uint64_t> digests(header->n_targets);
+
+    std::string bai = find_bai(bam_file);
+    if (!bai.empty() && digest_bai(bai, header, digests))
+        return digests;
+
+    // Respaldo: cualquier cambio en el archivo invalida todo
+    struct stat st{};
+    stat(bam_file.c_str(), &st);
+
+    for (int r = 0; r < header->n_targets; ++r) {
+        Digest d;
+        d.add(std::string(header->target_name[r]));
+        d.add(uint64_t(header->target_len[r]));
+        d.add(uint64_t(st.st_size));
+        d.add(uint64_t(st.st_mtime));
+        digests[r] = d.value();
+    }
+    return digests;
+}
+
+// "<ruta> <tamaño> <mtime s>.<ns> <inodo>"; "-" si el archivo no existe
+std::string file_stamp(const std::string& path) {
+    struct stat st{};
+    if (path.empty() || stat(path.c_str(), &st) != 0)
+        return "-";
+
+    std::ostringstream s;
+    s << path << " " << st.st_size << " "
+      << st.st_mtim.tv_sec << "." << st.st_mtim.tv_nsec << " " << st.st_ino;
+    return s.str();
+}
+
+/*
+ * Manifiesto: línea del BAM, línea del .bai, cantidad de cromosomas y
+ * una línea "<digest hex>\t<nombre>" por cromosoma en orden de tid.
+ */
+bool read_manifest(const std::string& manifest_file, const std::string& bam_stamp,
+                   const std::string& bai_stamp, const sam_hdr_t* header,
+                   std::vector<uint64_t>& digests) {
+    std::ifstream in(manifest_file);
+    std::string line;
+
+    if (!std::getline(in, line) || line != bam_stamp)
+        return false;
+    if (!std::getline(in, line) || line != bai_stamp)
+        return false;
+    if (!std::getline(in, line) || line != std::to_string(header->n_targets))
+        return false;
+
+    digests.assign(header->n_targets, 0);
+    for (int r = 0; r < header->n_targets; ++r) {
+        if (!std::getline(in, line))
+            return false;
+
+        size_t tab = line.find('\t');
+        if (tab != 16 || line.compare(tab + 1, std::string::npos, header->target_name[r]) != 0)
+            return false;
+        digests[r] = std::stoull(line.substr(0, tab), nullptr, 16);
+    }
+    return true;
+}
+
+void write_manifest(const std::string& manifest_file, const std::string& bam_stamp,
+                    const std::string& bai_stamp, const sam_hdr_t* header,
+                    const std::vector<uint64_t>& digests) {
+    std::string tmp = manifest_file + ".tmp";
+    {
+        std::ofstream out(tmp);
+        out << bam_stamp << "\n" << bai_stamp << "\n" << header->n_targets << "\n";
+        for (int r = 0; r < header->n_targets; ++r)
+            out << to_hex(digests[r]) << "\t" << header->target_name[r] << "\n";
+        if (!out)
+            throw std::runtime_error("No se pudo escribir " + tmp);
+    }
+    std::rename(tmp.c_str(), manifest_file.c_str());
+}
+
+} // namespace
+
+std::vector<uint64_t> contig_input_digests(const std::string& bam_file, const sam_hdr_t* header,
+                                           const std::string& manifest_file) {
+    if (manifest_file.empty())
+        return compute_digests(bam_file, header);
+
+    const std::string bam_stamp = file_stamp(bam_file);
+    const std::string bai_stamp = file_stamp(find_bai(bam_file));
+
+    std::vector<uint64_t> digests;
+    if (read_manifest(manifest_file, bam_stamp, bai_stamp, header, digests))
+        return digests;
+
+    digests = compute_digests(bam_file, header);
+    write_manifest(manifest_file, bam_stamp, bai_stamp, header, digests);
+    return digests;
+}
+
+} // namespace cnv
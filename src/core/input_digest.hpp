@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <htslib/sam.h>
+
+/*
+ * ============================
+ *   Digest de entradas
+ * ============================
+ *
+ * FNV-1a de 64 bits: no es criptográfico, solo identifica si cambiaron
+ * las entradas de una etapa (BAM, bin size, filtros, K, umbrales).
+ */
+
+namespace cnv {
+
+// 16 dígitos hexadecimales
+std::string to_hex(uint64_t v);
+
+class Digest {
+public:
+    Digest& add(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < len; ++i) {
+            h_ ^= p[i];
+            h_ *= 1099511628211ULL;
+        }
+        return *this;
+    }
+
+    Digest& add(uint64_t v) { return add(&v, sizeof(v)); }
+    Digest& add(float v) { return add(&v, sizeof(v)); }
+    Digest& add(const std::string& s) { add(uint64_t(s.size())); return add(s.data(), s.size()); }
+
+    uint64_t value() const { return h_; }
+    std::string hex() const { return to_hex(h_); }
+
+private:
+    uint64_t h_ = 14695981039346656037ULL;
+};
+
+/*
+ * Digest por cromosoma de su línea @SQ y de su sección del .bai: reads
+ * mapeados/no mapeados, bins con reads y largo del índice lineal. No
+ * entran los offsets de los chunks porque dependen de los bloques BGZF,
+ * que continúan de un cromosoma al siguiente: así re-alinear un
+ * cromosoma solo cambia su digest. Un cambio que conserve la cantidad
+ * de reads y sus bins (por ejemplo, un flag reescrito en el lugar) no
+ * se detecta; en ese caso hay que usar otro directorio de cache.
+ *
+ * Sin .bai legible (por ejemplo, índice .csi) se usa el tamaño y la
+ * fecha de modificación del BAM para todos los cromosomas.
+ *
+ * Con manifest_file, los digests se guardan junto al tamaño, la fecha
+ * de modificación y el inodo del BAM y del .bai, y se reutilizan sin
+ * leer el índice mientras esos datos coincidan.
+ */
+std::vector<uint64_t> contig_input_digests(const std::string& bam_file, const sam_hdr_t* header,
+                                           const std::string& manifest_file = "");
+
+} // namespace cnv
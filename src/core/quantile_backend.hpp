@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "kll_sketch.hpp"
+#include "csv_io.hpp"
+
+/*
+ * ============================
+ *   Backends de cuantiles
+ * ============================
+ *
+ * CoverageSketch es el KLL aproximado que usan todos los programas;
+ * ExactQuantiles guarda y ordena todos los valores y sirve de
+ * referencia para medir el error de rank.
+ */
+
+namespace cnv {
+
+using CoverageSketch = datasketches::kll_sketch<float>;
+
+// K del baseline si no se pide otro (kll_bam_reader --k)
+constexpr int DEFAULT_K = 400;
+
+// Envía al sketch cada bin con cobertura
+inline void update_sketch(CoverageSketch& sketch, const std::vector<uint32_t>& counts) {
+    for (uint32_t c : counts)
+        if (c > 0)
+            sketch.update(static_cast<float>(c));
+}
+
+// Percentiles y umbrales de CNV en el formato del CSV de baseline
+inline BaselineRow make_baseline_row(
+    const CoverageSketch& sketch,
+    int bin_size,
+    uint64_t total_bins,
+    double kll_time_sec
+) {
+    BaselineRow r{};
+    r.bin_size = bin_size;
+    r.total_bins = total_bins;
+
+    r.p1  = sketch.get_quantile(0.01);
+    r.p5  = sketch.get_quantile(0.05);
+    r.p25 = sketch.get_quantile(0.25);
+    r.p50 = sketch.get_quantile(0.50);
+    r.p75 = sketch.get_quantile(0.75);
+    r.p95 = sketch.get_quantile(0.95);
+    r.p99 = sketch.get_quantile(0.99);
+
+    r.min = sketch.get_min_item();
+    r.max = sketch.get_max_item();
+
+    r.iqr = r.p75 - r.p25;
+    r.deletion_threshold    = r.p50 * 0.5f;
+    r.duplication_threshold = r.p50 * 1.5f;
+
+    r.kll_items = sketch.get_num_retained();
+    r.kll_k = sketch.get_k();
+    r.kll_time_sec = kll_time_sec;
+    r.sample_fraction = 1.0;
+    return r;
+}
+
+class ExactQuantiles {
+public:
+    void add(uint32_t v) { values_.push_back(v); }
+
+    void add_nonzero(const std::vector<uint32_t>& counts) {
+        for (uint32_t c : counts)
+            if (c > 0)
+                values_.push_back(c);
+    }
+
+    // Debe llamarse antes de consultar cuantiles
+    void finalize() { std::sort(values_.begin(), values_.end()); }
+
+    const std::vector<uint32_t>& values() const { return values_; }
+    size_t size() const { return values_.size(); }
+
+    float quantile(double q) const {
+        size_t idx = static_cast<size_t>(q * (values_.size() - 1));
+        return static_cast<float>(values_[idx]);
+    }
+
+    // Distancia normalizada entre el rank real de value y el rank q
+    double rank_error(float value, double q) const {
+        auto it = std::lower_bound(values_.begin(), values_.end(), value);
+        size_t rank_kll = std::distance(values_.begin(), it);
+        size_t rank_exact = static_cast<size_t>(q * values_.size());
+        return std::abs((double)rank_kll - (double)rank_exact) / values_.size();
+    }
+
+private:
+    std::vector<uint32_t> values_;
+};
+
+} // namespace cnv
@@ -0,0 +1,175 @@
+#include "result_cache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "input_digest.hpp"
+
+namespace fs = std::filesystem;
+
+namespace cnv {
+
+uint64_t coverage_key(uint64_t contig_digest, int bin_size, uint16_t exclude_flags) {
+    return Digest().add(std::string("cov"))
+                   .add(contig_digest)
+                   .add(uint64_t(bin_size))
+                   .add(uint64_t(exclude_flags))
+                   .value();
+}
+
+uint64_t sketch_key(uint64_t coverage_key, int k) {
+    return Digest().add(std::string("kll"))
+                   .add(coverage_key)
+                   .add(uint64_t(k))
+                   .value();
+}
+
+uint64_t calls_key(uint64_t coverage_key, const BaselineStats& base) {
+    return Digest().add(std::string("cnv"))
+                   .add(coverage_key)
+                   .add(base.deletion_threshold)
+                   .add(base.duplication_threshold)
+                   .value();
+}
+
+namespace {
+
+// Los nombres de contig pueden traer '/', que no es válido en un archivo
+std::string file_safe(const std::string& contig) {
+    std::string s = contig;
+    for (char& c : s)
+        if (c == '/')
+            c = '_';
+    return s;
+}
+
+} // namespace
+
+ResultCache::ResultCache(const std::string& dir) : dir_(dir) {
+    fs::create_directories(dir_);
+}
+
+std::vector<uint64_t> ResultCache::input_digests(const std::string& bam_file,
+                                                 const sam_hdr_t* header) const {
+    return contig_input_digests(bam_file, header,
+                                (fs::path(dir_) / "input_digests.manifest").string());
+}
+
+std::string ResultCache::path(const std::string& contig, uint64_t key, const char* ext) const {
+    return (fs::path(dir_) / (file_safe(contig) + "." + to_hex(key) + ext)).string();
+}
+
+void ResultCache::commit(const std::string& tmp, const std::string& contig,
+                         uint64_t key, const char* ext) const {
+    std::string final_path = path(contig, key, ext);
+    fs::rename(tmp, final_path);
+
+    // <contig>.<16 hex><ext> con otra clave: versión anterior
+    const std::string prefix = file_safe(contig) + ".";
+    const std::string suffix = ext;
+    const size_t expected = prefix.size() + 16 + suffix.size();
+
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() == expected &&
+            name.compare(0, prefix.size(), prefix) == 0 &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+            entry.path() != fs::path(final_path))
+            fs::remove(entry.path());
+    }
+}
+
+bool ResultCache::load_coverage(const std::string& contig, uint64_t key, int bin_size,
+                                std::vector<uint32_t>& counts) const {
+    std::string p = path(contig, key, ".cov");
+    if (!fs::exists(p))
+        return false;
+
+    int cached_bin_size = 0;
+    std::vector<CoverageContig> contigs = read_coverage_cache(p, cached_bin_size);
+    if (cached_bin_size != bin_size || contigs.size() != 1)
+        return false;
+
+    counts = std::move(contigs[0].counts);
+    return true;
+}
+
+void ResultCache::save_coverage(const std::string& contig, uint64_t key, int bin_size,
+                                uint64_t contig_length, const std::vector<uint32_t>& counts) const {
+    std::string tmp = path(contig, key, ".cov.tmp");
+    {
+        CoverageCacheWriter writer(tmp, bin_size, 1);
+        writer.write(contig, contig_length, counts);
+    }
+    commit(tmp, contig, key, ".cov");
+}
+
+bool ResultCache::load_sketch(const std::string& contig, uint64_t key, CoverageSketch& sketch) const {
+    std::ifstream in(path(contig, key, ".kll"), std::ios::binary);
+    if (!in)
+        return false;
+
+    sketch = CoverageSketch::deserialize(in);
+    return true;
+}
+
+void ResultCache::save_sketch(const std::string& contig, uint64_t key, const CoverageSketch& sketch) const {
+    std::string tmp = path(contig, key, ".kll.tmp");
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        sketch.serialize(out);
+        if (!out)
+            throw std::runtime_error("No se pudo escribir " + tmp);
+    }
+    commit(tmp, contig, key, ".kll");
+}
+
+bool ResultCache::load_calls(const std::string& contig, uint64_t key, int32_t tid,
+                             CallArena& calls) const {
+    std::string p = path(contig, key, ".cnv.csv");
+    if (!fs::exists(p))
+        return false;
+
+    read_cnvs(p, tid, calls);
+    return true;
+}
+
+void ResultCache::save_calls(const std::string& contig, uint64_t key, const CallArena& calls,
+                             const char* const* contig_names) const {
+    std::string tmp = path(contig, key, ".cnv.csv.tmp");
+    {
+        std::ofstream out(tmp);
+        write_cnvs_header(out);
+        write_cnvs(out, calls, 0, contig_names);
+        if (!out)
+            throw std::runtime_error("No se pudo escribir " + tmp);
+    }
+    commit(tmp, contig, key, ".cnv.csv");
+}
+
+bool load_or_scan_coverage(
+    const ResultCache& cache,
+    BamScanner& bam,
+    int tid,
+    uint64_t key,
+    uint16_t exclude_flags,
+    CoverageBinner& binner,
+    std::vector<uint32_t>& counts
+) {
+    const std::string name = bam.contig_name(tid);
+
+    if (cache.load_coverage(name, key, binner.bin_size(), counts))
+        return true;
+
+    int64_t len = bam.contig_length(tid);
+    binner.reset(len);
+    bam.scan_region(tid, 0, len, exclude_flags,
+        [&](int, int64_t start, int64_t end) { binner.add(start, end); });
+
+    counts = binner.counts();
+    cache.save_coverage(name, key, binner.bin_size(), len, counts);
+    return false;
+}
+
+} // namespace cnv
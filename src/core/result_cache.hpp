@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "csv_io.hpp"
+#include "quantile_backend.hpp"
+
+/*
+ * ============================
+ *   Cache de resultados
+ * ============================
+ *
+ * Guarda por cromosoma las tres etapas del pipeline, cada una con la
+ * clave (digest) de sus entradas en el nombre del archivo:
+ *
+ *   <contig>.<clave>.cov       cobertura por bin (formato de csv_io)
+ *   <contig>.<clave>.kll       sketch KLL serializado
+ *   <contig>.<clave>.cnv.csv   llamadas de CNV sin filtrar por min_bins
+ *
+ * Una etapa se reutiliza si existe el archivo con su clave. Las claves
+ * se encadenan (cobertura → sketch / llamadas), así que cambiar K solo
+ * rehace los sketches y cambiar umbrales solo rehace las llamadas. Al
+ * guardar se borran las versiones anteriores de la misma etapa.
+ *
+ * Los digests de entrada por cromosoma quedan en input_digests.manifest
+ * para no releer el .bai mientras el BAM no cambie.
+ */
+
+namespace cnv {
+
+struct CacheKeys {
+    uint64_t coverage;
+    uint64_t sketch;
+    uint64_t calls;
+};
+
+// Claves de etapa a partir del digest de entrada del cromosoma
+uint64_t coverage_key(uint64_t contig_digest, int bin_size, uint16_t exclude_flags);
+uint64_t sketch_key(uint64_t coverage_key, int k);
+uint64_t calls_key(uint64_t coverage_key, const BaselineStats& base);
+
+class ResultCache {
+public:
+    explicit ResultCache(const std::string& dir);
+
+    // Digest de entrada por cromosoma (ver contig_input_digests)
+    std::vector<uint64_t> input_digests(const std::string& bam_file, const sam_hdr_t* header) const;
+
+    bool load_coverage(const std::string& contig, uint64_t key, int bin_size,
+                       std::vector<uint32_t>& counts) const;
+    void save_coverage(const std::string& contig, uint64_t key, int bin_size,
+                       uint64_t contig_length, const std::vector<uint32_t>& counts) const;
+
+    bool load_sketch(const std::string& contig, uint64_t key, CoverageSketch& sketch) const;
+    void save_sketch(const std::string& contig, uint64_t key, const CoverageSketch& sketch) const;
+
+    bool load_calls(const std::string& contig, uint64_t key, int32_t tid, CallArena& calls) const;
+    void save_calls(const std::string& contig, uint64_t key, const CallArena& calls,
+                    const char* const* contig_names) const;
+
+private:
+    std::string path(const std::string& contig, uint64_t key, const char* ext) const;
+    // Renombra tmp al archivo final y borra claves anteriores del contig
+    void commit(const std::string& tmp, const std::string& contig,
+                uint64_t key, const char* ext) const;
+
+    std::string dir_;
+};
+
+/*
+ * Cobertura del cromosoma tid: desde el cache si la clave coincide, o
+ * leyendo solo ese cromosoma del BAM vía índice y guardándola. Devuelve
+ * true si vino del cache.
+ */
+bool load_or_scan_coverage(
+    const ResultCache& cache,
+    BamScanner& bam,
+    int tid,
+    uint64_t key,
+    uint16_t exclude_flags,
+    CoverageBinner& binner,
+    std::vector<uint32_t>& counts
+);
+
+} // namespace cnv
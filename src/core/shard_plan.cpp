@@ -0,0 +1,112 @@
+#include "shard_plan.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace cnv {
+
+std::vector<ShardPiece> plan_shard(const sam_hdr_t* header, int bin_size, int index, int count) {
+    if (count <= 0 || index < 0 || index >= count)
+        throw std::runtime_error("Shard fuera de rango: " + std::to_string(index) +
+                                 " de " + std::to_string(count));
+
+    auto contig_bins = [&](int tid) {
+        return (uint64_t(header->target_len[tid]) + bin_size - 1) / bin_size;
+    };
+
+    uint64_t total = 0;
+    for (int tid = 0; tid < header->n_targets; ++tid)
+        total += contig_bins(tid);
+
+    uint64_t lo = total * index / count;
+    uint64_t hi = total * (index + 1) / count;
+
+    std::vector<ShardPiece> pieces;
+    uint64_t offset = 0;
+    for (int tid = 0; tid < header->n_targets; ++tid) {
+        uint64_t n = contig_bins(tid);
+        uint64_t b = std::max(lo, offset);
+        uint64_t e = std::min(hi, offset + n);
+        if (b < e)
+            pieces.push_back({tid, int64_t(b - offset), int64_t(e - b), e == offset + n});
+        offset += n;
+    }
+    return pieces;
+}
+
+std::string shard_path(const std::string& dir, int index, int count, const char* ext) {
+    return dir + "/shard_" + std::to_string(index) + "_of_" + std::to_string(count) + ext;
+}
+
+void write_runs(const std::string& csv_file, const std::vector<CallRun>& runs) {
+    std::ofstream out(csv_file);
+    if (!out)
+        throw std::runtime_error("No se pudo crear " + csv_file);
+
+    out << "tid,start_bin,num_bins,sum,type\n";
+    for (const CallRun& r : runs)
+        out << r.tid << ","
+            << r.start_bin << ","
+            << r.num_bins << ","
+            << r.sum << ","
+            << cnv_type_name(r.type) << "\n";
+
+    if (!out)
+        throw std::runtime_error("No se pudo escribir " + csv_file);
+}
+
+std::vector<CallRun> read_runs(const std::string& csv_file) {
+    std::ifstream in(csv_file);
+    if (!in)
+        throw std::runtime_error("No se pudo abrir " + csv_file);
+
+    std::vector<CallRun> runs;
+
+    std::string line;
+    std::getline(in, line); // header
+
+    while (std::getline(in, line)) {
+
+        std::stringstream ss(line);
+        std::string token;
+        CallRun r{};
+
+        std::getline(ss, token, ','); r.tid = std::stoi(token);
+        std::getline(ss, token, ','); r.start_bin = std::stoll(token);
+        std::getline(ss, token, ','); r.num_bins = std::stoull(token);
+        std::getline(ss, token, ','); r.sum = std::stoull(token);
+        std::getline(ss, token, ','); r.type = token == "DEL" ? CnvType::DEL : CnvType::DUP;
+
+        runs.push_back(r);
+    }
+
+    return runs;
+}
+
+void stitch_runs(const std::vector<CallRun>& runs, int bin_size, CallArena& calls) {
+    size_t i = 0;
+    while (i < runs.size()) {
+        CallRun r = runs[i++];
+
+        while (i < runs.size() &&
+               runs[i].tid == r.tid && runs[i].type == r.type &&
+               runs[i].start_bin == r.start_bin + int64_t(r.num_bins)) {
+            r.num_bins += runs[i].num_bins;
+            r.sum += runs[i].sum;
+            ++i;
+        }
+
+        // Mismos cálculos que flush_run en el segmentador
+        CNV& cnv = calls.emplace();
+        cnv.tid = r.tid;
+        cnv.start = uint64_t(r.start_bin) * bin_size;
+        cnv.end   = uint64_t(r.start_bin + r.num_bins) * bin_size;
+        cnv.type  = r.type;
+        cnv.num_bins = r.num_bins;
+        cnv.mean_coverage = float(r.sum) / r.num_bins;
+    }
+}
+
+} // namespace cnv
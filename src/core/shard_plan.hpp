@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <htslib/sam.h>
+
+#include "cnv_calls.hpp"
+
+/*
+ * ============================
+ *   Reparto en shards
+ * ============================
+ *
+ * El genoma se ve como la concatenación de los bins de todos los
+ * cromosomas del header (en su orden) y se corta en n_shards tramos
+ * contiguos de igual cantidad de bins. Cada shard procesa las porciones
+ * de cromosoma que caen en su tramo leyendo solo esas regiones vía .bai;
+ * los cortes caen siempre en borde de bin, así que los conteos de cada
+ * porción son exactamente los de la pasada completa.
+ *
+ * Las rachas de CNV se guardan con la suma de cobertura de sus bins.
+ * Una racha que llega al borde de una porción queda abierta: el reduce
+ * la une con la siguiente si son contiguas y del mismo tipo. Dentro de
+ * una porción el segmentador nunca deja dos rachas así, de modo que la
+ * misma regla no altera el resto de las llamadas.
+ */
+
+namespace cnv {
+
+struct ShardPiece {
+    int tid;
+    int64_t first_bin;
+    int64_t n_bins;
+    bool contig_end;    // la porción llega al final del cromosoma
+};
+
+// Porciones del shard index (0 <= index < count), en orden del header
+std::vector<ShardPiece> plan_shard(const sam_hdr_t* header, int bin_size, int index, int count);
+
+// <dir>/shard_<index>_of_<count><ext>
+std::string shard_path(const std::string& dir, int index, int count, const char* ext);
+
+struct CallRun {
+    int32_t tid;
+    int64_t start_bin;
+    uint64_t num_bins;
+    uint64_t sum;
+    CnvType type;
+};
+
+// CSV tid,start_bin,num_bins,sum,type
+void write_runs(const std::string& csv_file, const std::vector<CallRun>& runs);
+std::vector<CallRun> read_runs(const std::string& csv_file);
+
+// Une rachas consecutivas contiguas del mismo tipo y las agrega como
+// llamadas; runs debe venir en orden genómico (shards en orden)
+void stitch_runs(const std::vector<CallRun>& runs, int bin_size, CallArena& calls);
+
+} // namespace cnv
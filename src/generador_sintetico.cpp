@@ -0,0 +1,419 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+
+#include <htslib/sam.h>
+
+#include "coverage_binner.hpp"
+#include "csv_io.hpp"
+
+using namespace cnv;
+
+/*
+ * ============================
+ *   Generador sintético de WGS
+ * ============================
+ *
+ * Escribe un BAM ordenado por coordenada (con su .bai), un cache de
+ * cobertura por bin y el truth set de CNVs plantados, para medir
+ * throughput, memoria y recall sin depender de HG002.
+ *
+ * Los reads se generan contig a contig y en orden de coordenada: el
+ * genoma se recorre en segmentos de tasa constante (cortados por la
+ * ventana de ruido y por los bordes de cada evento) y en cada uno se
+ * sortea un número Poisson de inicios uniformes. La memoria es la del
+ * cache de cobertura del contig en curso, independiente de la
+ * profundidad, así que escala de 1 GB a 1 TB de salida.
+ *
+ * El cache (formato en csv_io.hpp) cuenta los reads primarios sin
+ * duplicados con el mismo CoverageBinner que usan los lectores de BAM.
+ */
+
+struct GeneratorConfig {
+    std::string prefix;
+    uint64_t genome_size = 100000000;
+    int contigs = 5;
+    double depth = 30.0;
+    int read_length = 150;
+    double dup_fraction = 0.05;
+    double secondary_fraction = 0.01;
+    std::string noise = "gamma";     // "poisson" o "gamma"
+    double dispersion = 0.01;        // varianza del factor gamma (media 1)
+    int noise_window = 1000;
+    int events = 20;
+    int event_min = 10000;
+    int event_max = 200000;
+    int bin_size = 1000;
+    std::string output = "both";     // "bam", "cache" o "both"
+    int threads = 1;
+    uint64_t seed = 1;
+};
+
+struct PlantedEvent {
+    int tid;
+    int64_t start;
+    int64_t end;
+    int copy_number;
+};
+
+struct Contig {
+    std::string name;
+    int64_t length;
+};
+
+/*
+ * ============================
+ *   Eventos plantados
+ * ============================
+ */
+
+std::vector<PlantedEvent> plant_events(
+    const GeneratorConfig& cfg,
+    const std::vector<Contig>& contigs,
+    std::mt19937_64& rng
+) {
+    std::vector<PlantedEvent> events;
+
+    // Coordenadas alineadas a bin_size para que el truth set sea comparable
+    int64_t bs = cfg.bin_size;
+    int64_t min_bins = std::max<int64_t>(1, cfg.event_min / bs);
+    int64_t max_bins = std::max<int64_t>(min_bins, cfg.event_max / bs);
+
+    std::uniform_int_distribution<int> pick_contig(0, int(contigs.size()) - 1);
+    std::uniform_int_distribution<int64_t> pick_len(min_bins, max_bins);
+    std::bernoulli_distribution is_del(0.5);
+    std::bernoulli_distribution strong(0.5);
+
+    for (int e = 0; e < cfg.events; ++e) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            int tid = pick_contig(rng);
+            int64_t len_bins = pick_len(rng);
+            int64_t contig_bins = contigs[tid].length / bs;
+            if (len_bins + 2 >= contig_bins)
+                continue;
+
+            std::uniform_int_distribution<int64_t> pick_start(1, contig_bins - len_bins - 1);
+            PlantedEvent ev;
+            ev.tid = tid;
+            ev.start = pick_start(rng) * bs;
+            ev.end = ev.start + len_bins * bs;
+
+            // Se deja al menos un bin normal entre eventos
+            bool overlaps = false;
+            for (const auto& o : events)
+                if (o.tid == tid && ev.start < o.end + bs && o.start < ev.end + bs)
+                    overlaps = true;
+            if (overlaps)
+                continue;
+
+            if (is_del(rng))
+                ev.copy_number = strong(rng) ? 0 : 1;
+            else
+                ev.copy_number = strong(rng) ? 4 : 3;
+
+            events.push_back(ev);
+            break;
+        }
+    }
+
+    std::sort(events.begin(), events.end(),
+              [](const PlantedEvent& a, const PlantedEvent& b) {
+                  return a.tid != b.tid ? a.tid < b.tid : a.start < b.start;
+              });
+    return events;
+}
+
+/*
+ * ============================
+ *   Argumentos
+ * ============================
+ */
+
+bool parse_args(int argc, char* argv[], GeneratorConfig& cfg) {
+    if (argc < 2)
+        return false;
+
+    cfg.prefix = argv[1];
+
+    for (int i = 2; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (i + 1 >= argc)
+            return false;
+        const char* val = argv[++i];
+
+        if (opt == "--genome-size")             cfg.genome_size = std::strtoull(val, nullptr, 10);
+        else if (opt == "--contigs")            cfg.contigs = std::atoi(val);
+        else if (opt == "--depth")              cfg.depth = std::atof(val);
+        else if (opt == "--read-length")        cfg.read_length = std::atoi(val);
+        else if (opt == "--dup-fraction")       cfg.dup_fraction = std::atof(val);
+        else if (opt == "--secondary-fraction") cfg.secondary_fraction = std::atof(val);
+        else if (opt == "--noise")              cfg.noise = val;
+        else if (opt == "--dispersion")         cfg.dispersion = std::atof(val);
+        else if (opt == "--noise-window")       cfg.noise_window = std::atoi(val);
+        else if (opt == "--events")             cfg.events = std::atoi(val);
+        else if (opt == "--event-min")          cfg.event_min = std::atoi(val);
+        else if (opt == "--event-max")          cfg.event_max = std::atoi(val);
+        else if (opt == "--bin-size")           cfg.bin_size = std::atoi(val);
+        else if (opt == "--output")             cfg.output = val;
+        else if (opt == "--threads")            cfg.threads = std::atoi(val);
+        else if (opt == "--seed")               cfg.seed = std::strtoull(val, nullptr, 10);
+        else {
+            std::cerr << "Opción desconocida: " << opt << "\n";
+            return false;
+        }
+    }
+
+    if (cfg.contigs <= 0 || cfg.read_length <= 0 || cfg.bin_size <= 0 ||
+        cfg.noise_window <= 0 || cfg.depth <= 0.0) {
+        std::cerr << "Parámetros numéricos inválidos\n";
+        return false;
+    }
+    if (cfg.genome_size / cfg.contigs >= (1ULL << 31)) {
+        std::cerr << "Cada contig debe medir menos de 2^31 bp; aumentar --contigs\n";
+        return false;
+    }
+    if (cfg.genome_size / cfg.contigs <= uint64_t(cfg.read_length)) {
+        std::cerr << "Contigs más cortos que el largo de read\n";
+        return false;
+    }
+    if (cfg.noise != "poisson" && cfg.noise != "gamma") {
+        std::cerr << "--noise debe ser poisson o gamma\n";
+        return false;
+    }
+    if (cfg.noise == "gamma" && cfg.dispersion <= 0.0) {
+        std::cerr << "--dispersion debe ser positiva con ruido gamma\n";
+        return false;
+    }
+    if (cfg.output != "bam" && cfg.output != "cache" && cfg.output != "both") {
+        std::cerr << "--output debe ser bam, cache o both\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * ============================
+ *   MAIN
+ * ============================
+ */
+
+int main(int argc, char* argv[]) {
+
+    GeneratorConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        std::cerr << "Uso: " << argv[0] << " <prefijo_salida>"
+                  << " [--genome-size bp] [--contigs n] [--depth x]"
+                  << " [--read-length bp] [--dup-fraction f] [--secondary-fraction f]"
+                  << " [--noise poisson|gamma] [--dispersion d] [--noise-window bp]"
+                  << " [--events n] [--event-min bp] [--event-max bp]"
+                  << " [--bin-size bp] [--output bam|cache|both] [--threads n] [--seed n]\n";
+        return 1;
+    }
+
+    const bool write_bam = cfg.output != "cache";
+    const bool write_cache = cfg.output != "bam";
+
+    std::string bam_file = cfg.prefix + ".bam";
+    std::string cache_file = cfg.prefix + ".cov";
+    std::string truth_file = cfg.prefix + "_truth.csv";
+
+    using clock = std::chrono::steady_clock;
+    auto t_start = clock::now();
+
+    // Dos motores: rng decide la cobertura (eventos, ruido y posiciones) y
+    // content_rng solo lo que va al BAM (bases, hebra, duplicados,
+    // secundarios). Así --output cache da el mismo .cov que bam|both.
+    std::mt19937_64 rng(cfg.seed);
+    std::mt19937_64 content_rng(cfg.seed ^ 0x9E3779B97F4A7C15ULL);
+
+    // --- Contigs ---
+    std::vector<Contig> contigs;
+    int64_t contig_len = int64_t(cfg.genome_size / cfg.contigs);
+    for (int i = 0; i < cfg.contigs; ++i)
+        contigs.push_back({"chr" + std::to_string(i + 1), contig_len});
+
+    std::vector<PlantedEvent> events = plant_events(cfg, contigs, rng);
+
+    // --- Truth set ---
+    std::ofstream truth(truth_file);
+    truth << "chr,start,end,type,copy_number\n";
+    for (const auto& ev : events)
+        truth << contigs[ev.tid].name << ","
+              << ev.start << ","
+              << ev.end << ","
+              << (ev.copy_number < 2 ? "DEL" : "DUP") << ","
+              << ev.copy_number << "\n";
+    truth.close();
+
+    // --- Header BAM ---
+    std::string header_text = "@HD\tVN:1.6\tSO:coordinate\n";
+    for (const auto& c : contigs)
+        header_text += "@SQ\tSN:" + c.name + "\tLN:" + std::to_string(c.length) + "\n";
+    header_text += "@PG\tID:generador_sintetico\tPN:generador_sintetico\n";
+
+    sam_hdr_t* header = sam_hdr_parse(header_text.size(), header_text.c_str());
+    samFile* bam_fp = nullptr;
+    bam1_t* aln = bam_init1();
+
+    if (write_bam) {
+        bam_fp = sam_open(bam_file.c_str(), "wb");
+        if (!bam_fp || !header || sam_hdr_write(bam_fp, header) < 0) {
+            std::cerr << "Error escribiendo BAM\n";
+            return 1;
+        }
+        if (cfg.threads > 1)
+            hts_set_threads(bam_fp, cfg.threads);
+    }
+
+    std::unique_ptr<CoverageCacheWriter> cache;
+    if (write_cache) {
+        try {
+            cache.reset(new CoverageCacheWriter(cache_file, cfg.bin_size, contigs.size()));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // --- Reads ---
+    const int rl = cfg.read_length;
+    const double base_rate = cfg.depth / rl;   // inicios por bp con CN = 2
+    const uint32_t cigar[1] = { bam_cigar_gen(uint32_t(rl), BAM_CMATCH) };
+
+    std::string seq(rl, 'A');
+    std::string qual(rl, char(30));
+    std::string qname;
+    static const char BASES[4] = {'A', 'C', 'G', 'T'};
+
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    std::gamma_distribution<double> gamma(1.0 / cfg.dispersion, cfg.dispersion);
+
+    std::vector<int64_t> starts;
+    CoverageBinner binner(cfg.bin_size);
+
+    uint64_t reads_written = 0;
+    uint64_t read_id = 0;
+
+    auto emit = [&](int tid, int64_t pos, uint16_t flag, uint8_t mapq) {
+        for (int i = 0; i < rl; ++i)
+            seq[i] = BASES[content_rng() & 3];
+        qname = "r" + std::to_string(read_id);
+
+        bam_set1(aln, qname.size(), qname.c_str(), flag, tid, pos, mapq,
+                 1, cigar, -1, -1, 0, rl, seq.c_str(), qual.c_str(), 0);
+
+        if (sam_write1(bam_fp, header, aln) < 0) {
+            std::cerr << "Error escribiendo read\n";
+            std::exit(1);
+        }
+        reads_written++;
+    };
+
+    size_t next_event = 0;
+
+    for (int tid = 0; tid < int(contigs.size()); ++tid) {
+
+        const int64_t len = contigs[tid].length;
+        const int64_t last_start = len - rl;   // los reads no sobrepasan el contig
+
+        binner.reset(len);
+
+        double noise_factor = 1.0;
+        int64_t pos = 0;
+
+        while (pos <= last_start) {
+
+            // Nuevo factor de ruido al inicio de cada ventana
+            if (pos % cfg.noise_window == 0 && cfg.noise == "gamma")
+                noise_factor = gamma(rng);
+
+            while (next_event < events.size() &&
+                   (events[next_event].tid < tid ||
+                    (events[next_event].tid == tid && events[next_event].end <= pos)))
+                next_event++;
+
+            int copy_number = 2;
+            int64_t seg_end = std::min<int64_t>(
+                (pos / cfg.noise_window + 1) * cfg.noise_window, last_start + 1);
+
+            if (next_event < events.size() && events[next_event].tid == tid) {
+                const PlantedEvent& ev = events[next_event];
+                if (pos >= ev.start) {
+                    copy_number = ev.copy_number;
+                    seg_end = std::min(seg_end, ev.end);
+                }
+                else {
+                    seg_end = std::min(seg_end, ev.start);
+                }
+            }
+
+            double lambda = base_rate * (copy_number / 2.0) * noise_factor * (seg_end - pos);
+            uint64_t n = lambda > 0.0
+                ? std::poisson_distribution<uint64_t>(lambda)(rng)
+                : 0;
+
+            starts.resize(n);
+            std::uniform_int_distribution<int64_t> pick_pos(pos, seg_end - 1);
+            for (auto& s : starts)
+                s = pick_pos(rng);
+            std::sort(starts.begin(), starts.end());
+
+            for (int64_t s : starts) {
+                read_id++;
+
+                binner.add(s, s + rl);
+
+                if (write_bam) {
+                    uint16_t flag = unif(content_rng) < 0.5 ? BAM_FREVERSE : 0;
+                    emit(tid, s, flag, 60);
+                    if (unif(content_rng) < cfg.dup_fraction)
+                        emit(tid, s, flag | BAM_FDUP, 60);
+                    if (unif(content_rng) < cfg.secondary_fraction)
+                        emit(tid, s, flag | BAM_FSECONDARY, 0);
+                }
+            }
+
+            pos = seg_end;
+        }
+
+        if (write_cache)
+            cache->write(contigs[tid].name, len, binner.counts());
+
+        std::cout << contigs[tid].name << " listo (" << read_id << " reads primarios)\n";
+    }
+
+    bam_destroy1(aln);
+
+    if (write_bam) {
+        sam_close(bam_fp);
+        if (sam_index_build(bam_file.c_str(), 0) < 0) {
+            std::cerr << "Error indexando " << bam_file << "\n";
+            return 1;
+        }
+    }
+    sam_hdr_destroy(header);
+
+    if (write_cache)
+        cache->close();
+
+    std::chrono::duration<double> elapsed = clock::now() - t_start;
+
+    std::cout << "Reads primarios: " << read_id << "\n";
+    if (write_bam)
+        std::cout << "Registros BAM:   " << reads_written << " → " << bam_file << "\n";
+    if (write_cache)
+        std::cout << "Cache cobertura: " << cache_file << "\n";
+    std::cout << "Eventos:         " << events.size() << " → " << truth_file << "\n";
+    std::cout << "Tiempo:          " << std::fixed << std::setprecision(2)
+              << elapsed.count() << " s\n";
+
+    return 0;
+}
@@ -1,41 +1,18 @@
 #include <iostream>
 #include <iomanip>
-#include <unordered_map>
 #include <string>
 #include <chrono>
 #include <fstream>
 #include <vector>
-#include <algorithm>
-#include <cmath>
 #include <cstdlib>
 
-#include <htslib/sam.h>
-#include "kll_sketch.hpp"
+#include "bam_scanner.hpp"
+#include "coverage_binner.hpp"
+#include "quantile_backend.hpp"
 
-
-using namespace datasketches;
+using namespace cnv;
 using hr_clock = std::chrono::steady_clock;
 
-/* ===============================
-   Utilidades baseline exacto
-   =============================== */
-
-float exact_quantile(const std::vector<uint32_t>& v, double q) {
-    size_t idx = static_cast<size_t>(q * (v.size() - 1));
-    return static_cast<float>(v[idx]);
-}
-
-double rank_error(
-    const std::vector<uint32_t>& v,
-    float value,
-    double q
-) {
-    auto it = std::lower_bound(v.begin(), v.end(), value);
-    size_t rank_kll = std::distance(v.begin(), it);
-    size_t rank_exact = static_cast<size_t>(q * v.size());
-    return std::abs((double)rank_kll - (double)rank_exact) / v.size();
-}
-
 int main(int argc, char* argv[]) {
 
     if (argc != 4) {
@@ -48,106 +25,80 @@ int main(int argc, char* argv[]) {
     int bin_size = std::atoi(argv[2]);
     const char* csv_file = argv[3];
 
-    /* ===============================
-       1️⃣ BASELINE EXACTO
-       =============================== */
-
-    samFile* bam_fp = sam_open(bam_file, "r");
-    sam_hdr_t* header = sam_hdr_read(bam_fp);
-    bam1_t* aln = bam_init1();
+    try {
+        /* ===============================
+           1️⃣ BASELINE EXACTO
+           =============================== */
 
-    std::string current_chr;
-    std::unordered_map<uint32_t, uint32_t> bins;
-    bins.reserve(100000);
+        BamScanner bam(bam_file);
+        CoverageBinner binner(bin_size);
 
-    std::vector<uint32_t> exact_values;
+        ExactQuantiles exact;
 
-    while (sam_read1(bam_fp, header, aln) >= 0) {
+        bam.scan(DEFAULT_EXCLUDE_FLAGS,
+            [&](int, int64_t start, int64_t end) { binner.add(start, end); },
+            [&](int) {
+                exact.add_nonzero(binner.counts());
+                binner.clear();
+            });
 
-        if (aln->core.flag & (BAM_FUNMAP |
-                              BAM_FSECONDARY |
-                              BAM_FSUPPLEMENTARY |
-                              BAM_FDUP))
-            continue;
+        exact.finalize();
+        const std::vector<uint32_t>& exact_values = exact.values();
 
-        std::string chr = header->target_name[aln->core.tid];
+        /* ===============================
+           CSV header
+           =============================== */
 
-        if (current_chr.empty())
-            current_chr = chr;
+        std::ofstream out(csv_file);
+        out << std::fixed << std::setprecision(6);
+        out << "bin_size,K,"
+            << "p5_kll,p5_exact,p5_rank_error,"
+            << "p50_kll,p50_exact,p50_rank_error,"
+            << "p95_kll,p95_exact,p95_rank_error,"
+            << "kll_time_sec,kll_bytes\n";
 
-        if (chr != current_chr) {
-            for (const auto& e : bins)
-                exact_values.push_back(e.second);
-            bins.clear();
-            current_chr = chr;
-        }
+        /* ===============================
+           2️⃣ EXPERIMENTO KLL
+           =============================== */
 
-        int start = aln->core.pos;
-        int end   = bam_endpos(aln);
-
-        for (int p = start; p < end; p += bin_size)
-            bins[p / bin_size]++;
-    }
+        for (int K : {100, 200, 300, 400, 500, 1000, 2000}) {
 
-    for (const auto& e : bins)
-        exact_values.push_back(e.second);
+            CoverageSketch sketch(K);
+            auto t1 = hr_clock::now();
 
-    bam_destroy1(aln);
-    sam_hdr_destroy(header);
-    sam_close(bam_fp);
+            for (uint32_t v : exact_values)
+                sketch.update(static_cast<float>(v));
 
-    std::sort(exact_values.begin(), exact_values.end());
-    size_t N = exact_values.size();
+            auto t2 = hr_clock::now();
+            double kll_time = std::chrono::duration<double>(t2 - t1).count();
 
-    /* ===============================
-       CSV header
-       =============================== */
+            float p5_kll = sketch.get_quantile(0.05);
+            float p50_kll = sketch.get_quantile(0.50);
+            float p95_kll = sketch.get_quantile(0.95);
 
-    std::ofstream out(csv_file);
-    out << std::fixed << std::setprecision(6);
-    out << "bin_size,K,"
-        << "p5_kll,p5_exact,p5_rank_error,"
-        << "p50_kll,p50_exact,p50_rank_error,"
-        << "p95_kll,p95_exact,p95_rank_error,"
-        << "kll_time_sec,kll_bytes\n";
+            float p5_exact = exact.quantile(0.05);
+            float p50_exact = exact.quantile(0.50);
+            float p95_exact = exact.quantile(0.95);
 
-    /* ===============================
-       2️⃣ EXPERIMENTO KLL
-       =============================== */
+            double p5_err = exact.rank_error(p5_kll, 0.05);
+            double p50_err = exact.rank_error(p50_kll, 0.50);
+            double p95_err = exact.rank_error(p95_kll, 0.95);
 
-    for (int K : {100, 200, 300, 400, 500, 1000, 2000}) {
+            size_t bytes = sketch.get_serialized_size_bytes();
 
-        kll_sketch<float> sketch(K);
-        auto t1 = hr_clock::now();
-
-        for (uint32_t v : exact_values)
-            sketch.update(static_cast<float>(v));
-
-        auto t2 = hr_clock::now();
-        double kll_time = std::chrono::duration<double>(t2 - t1).count();
-
-        float p5_kll = sketch.get_quantile(0.05);
-        float p50_kll = sketch.get_quantile(0.50);
-        float p95_kll = sketch.get_quantile(0.95);
-
-        float p5_exact = exact_quantile(exact_values, 0.05);
-        float p50_exact = exact_quantile(exact_values, 0.50);
-        float p95_exact = exact_quantile(exact_values, 0.95);
-
-        double p5_err = rank_error(exact_values, p5_kll, 0.05);
-        double p50_err = rank_error(exact_values, p50_kll, 0.50);
-        double p95_err = rank_error(exact_values, p95_kll, 0.95);
-        
-
-        size_t bytes = sketch.get_serialized_size_bytes();
+            out << bin_size << "," << K << ","
+                << p5_kll << "," << p5_exact << "," << p5_err << ","
+                << p50_kll << "," << p50_exact << "," << p50_err << ","
+                << p95_kll << "," << p95_exact << "," << p95_err << ","
+                << kll_time << "," << bytes << "\n";
+        }
 
-        out << bin_size << "," << K << ","
-            << p5_kll << "," << p5_exact << "," << p5_err << ","
-            << p50_kll << "," << p50_exact << "," << p50_err << ","
-            << p95_kll << "," << p95_exact << "," << p95_err << ","
-            << kll_time << "," << bytes << "\n";
+        out.close();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
     }
 
-    out.close();
     return 0;
 }
@@ -0,0 +1,64 @@
+#!/bin/sh
+# --cache: una segunda pasada no lee el BAM, cambiar K reutiliza todas
+# las coberturas, cambiar umbrales reutiliza coberturas pero rehace las
+# llamadas, y la salida de cnv_pasada con cache es idéntica a sin cache.
+# Uso: cache_incremental.sh <generador> <kll_bam_reader> <cnv_pasada> <dir>
+set -e
+
+GEN=$1; READER=$2; PASADA=$3; WORK=$4
+
+rm -rf "$WORK"
+mkdir -p "$WORK"
+cd "$WORK"
+
+"$GEN" sim --genome-size 3000000 --contigs 3 --depth 10 --events 12 --seed 11 > /dev/null
+
+# expect <salida> <texto>: la línea "Cache ..." debe contener el texto
+expect() {
+    line=$(grep "^Cache " "$1")
+    case "$line" in
+        *"$2"*) ;;
+        *) echo "esperaba '$2' en: $line"; exit 1 ;;
+    esac
+}
+
+"$READER" sim.bam 1000 base.csv --cache c > out.txt
+expect out.txt "3 cromosomas, 0 sketches reutilizados, 0 coberturas reutilizadas, 3 leídos del BAM"
+
+# Segunda pasada: todo desde el cache
+"$READER" sim.bam 1000 base.csv --cache c > out.txt
+expect out.txt "3 sketches reutilizados, 0 coberturas reutilizadas, 0 leídos del BAM"
+
+# Otro K: solo se rehacen los sketches
+"$READER" sim.bam 1000 base.csv --cache c --k 200 > out.txt
+expect out.txt "0 sketches reutilizados, 3 coberturas reutilizadas, 0 leídos del BAM"
+
+# Fecha de modificación nueva sin cambiar el contenido: se rehace el
+# manifiesto desde el .bai y las claves no cambian
+touch sim.bam
+"$READER" sim.bam 1000 base.csv --cache c --k 200 > out.txt
+expect out.txt "3 sketches reutilizados, 0 coberturas reutilizadas, 0 leídos del BAM"
+
+# cnv_pasada con cache (coberturas de kll_bam_reader) igual a sin cache
+"$PASADA" sim.bam 1000 base.csv plain.csv 1 > /dev/null
+"$PASADA" sim.bam 1000 base.csv cached.csv 1 --cache c > out.txt
+expect out.txt "0 llamadas reutilizadas, 3 coberturas reutilizadas, 0 leídos del BAM"
+cmp plain.csv cached.csv
+
+"$PASADA" sim.bam 1000 base.csv cached.csv 1 --cache c > out.txt
+expect out.txt "3 llamadas reutilizadas, 0 coberturas reutilizadas, 0 leídos del BAM"
+cmp plain.csv cached.csv
+
+# Otros umbrales: se reutiliza la cobertura y se rehacen las llamadas
+awk -F, 'BEGIN { OFS = "," } NR > 1 { $13 = $13 * 1.2; $14 = $14 * 0.9 } { print }' \
+    base.csv > base2.csv
+"$PASADA" sim.bam 1000 base2.csv plain2.csv 1 > /dev/null
+"$PASADA" sim.bam 1000 base2.csv cached2.csv 1 --cache c > out.txt
+expect out.txt "0 llamadas reutilizadas, 3 coberturas reutilizadas, 0 leídos del BAM"
+cmp plain2.csv cached2.csv
+if cmp -s plain.csv plain2.csv; then
+    echo "los umbrales nuevos no cambiaron las llamadas"
+    exit 1
+fi
+
+echo "cache incremental: OK"
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Con la misma semilla, --output cache debe dar el mismo .cov que
+# --output both, y kll_bam_reader/cnv_pasada --coverage sobre ese .cov
+# deben dar lo mismo que sobre el BAM.
+# Uso: generador_modos.sh <generador> <kll_bam_reader> <cnv_pasada> <dir>
+set -e
+
+GEN=$1; READER=$2; PASADA=$3; WORK=$4
+
+rm -rf "$WORK"
+mkdir -p "$WORK"
+cd "$WORK"
+
+for NOISE in poisson gamma; do
+    ARGS="--genome-size 2000000 --contigs 2 --depth 10 --events 10 --noise $NOISE
+          --dup-fraction 0.1 --secondary-fraction 0.05 --seed 5"
+
+    "$GEN" both_$NOISE $ARGS --output both > /dev/null
+    "$GEN" cache_$NOISE $ARGS --output cache > /dev/null
+
+    cmp both_$NOISE.cov cache_$NOISE.cov
+    cmp both_${NOISE}_truth.csv cache_${NOISE}_truth.csv
+
+    # El .cov reemplaza al BAM: misma fila de baseline (sin el tiempo)
+    # y mismas llamadas
+    "$READER" both_$NOISE.bam 1000 baseline_bam_$NOISE.csv > /dev/null
+    "$READER" --coverage cache_$NOISE.cov 1000 baseline_cov_$NOISE.csv > /dev/null
+    cut -d, -f1-16,18 baseline_bam_$NOISE.csv > a.csv
+    cut -d, -f1-16,18 baseline_cov_$NOISE.csv > b.csv
+    cmp a.csv b.csv
+
+    "$PASADA" both_$NOISE.bam 1000 baseline_bam_$NOISE.csv cnvs_bam_$NOISE.csv 1 > /dev/null
+    "$PASADA" --coverage cache_$NOISE.cov 1000 baseline_bam_$NOISE.csv cnvs_cov_$NOISE.csv 1 > /dev/null
+    cmp cnvs_bam_$NOISE.csv cnvs_cov_$NOISE.csv
+done
+
+echo "generador: OK"
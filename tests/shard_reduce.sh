@@ -0,0 +1,66 @@
+#!/bin/sh
+# Compara shard/reduce contra la pasada de un solo proceso sobre un BAM
+# sintético. Uso: shard_reduce.sh <generador> <kll_bam_reader> <cnv_pasada> <cnv_shard> <dir>
+set -e
+
+GEN=$1; READER=$2; PASADA=$3; SHARD=$4; WORK=$5
+BIN=1000
+
+rm -rf "$WORK"
+mkdir -p "$WORK"
+cd "$WORK"
+
+"$GEN" sint --genome-size 3000000 --contigs 3 --depth 10 --events 20 --seed 3 > /dev/null
+
+# --- Un solo proceso ---
+"$READER" sint.bam $BIN baseline_1p.csv > /dev/null
+"$PASADA" sint.bam $BIN baseline_1p.csv cnvs_1p.csv 1 > /dev/null
+
+# --- Shards: cantidades que cortan cromosomas y eventos ---
+for N in 1 4 37; do
+    I=0
+    while [ $I -lt $N ]; do
+        "$SHARD" shard sint.bam $BIN $I $N s$N > /dev/null
+        I=$((I + 1))
+    done
+    "$SHARD" reduce sint.bam $BIN $N s$N --baseline-out baseline_$N.csv > /dev/null
+
+    I=0
+    while [ $I -lt $N ]; do
+        "$SHARD" shard sint.bam $BIN $I $N s$N --baseline baseline_1p.csv > /dev/null
+        I=$((I + 1))
+    done
+    "$SHARD" reduce sint.bam $BIN $N s$N --cnvs-out cnvs_$N.csv 1
+
+    # Las llamadas deben ser idénticas
+    cmp cnvs_1p.csv cnvs_$N.csv
+
+    # Baseline: mismas columnas bin_size,total_bins; los cuantiles del
+    # sketch unido solo son estadísticamente equivalentes, se exige que
+    # la mediana no se aleje más de un 5 %
+    awk -F, 'NR == FNR { if (FNR == 2) { bs = $1; tb = $2; p50 = $6 } next }
+             FNR == 2 { d = $6 - p50; if (d < 0) d = -d
+                        if ($1 != bs || $2 != tb || d > 0.05 * p50) exit 1 }' \
+        baseline_1p.csv baseline_$N.csv
+done
+
+# --- --k: el sketch unido lleva el K pedido y reduce rechaza shards con
+# otro K ---
+I=0
+while [ $I -lt 4 ]; do
+    "$SHARD" shard sint.bam $BIN $I 4 k200 --k 200 > /dev/null
+    I=$((I + 1))
+done
+"$SHARD" reduce sint.bam $BIN 4 k200 --k 200 --baseline-out baseline_k200.csv > /dev/null
+awk -F, 'FNR == 2 && $16 != 200 { exit 1 }' baseline_k200.csv
+
+if "$SHARD" reduce sint.bam $BIN 4 k200 --baseline-out baseline_kmix.csv > /dev/null 2>&1; then
+    echo "reduce aceptó sketches con otro K"
+    exit 1
+fi
+if "$SHARD" shard sint.bam $BIN 0 4 k200 --k 7 > /dev/null 2>&1; then
+    echo "shard aceptó --k 7"
+    exit 1
+fi
+
+echo "shard/reduce: OK"